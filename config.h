@@ -0,0 +1,3 @@
+#define COMPILE "gcc -Wall -O3 -DNDEBUG"
+#define IDENTIFIER "b16839521994fd0e4dd75721b5b91775cc408325"
+#define VERSION "0.0.1"
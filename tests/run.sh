@@ -0,0 +1,81 @@
+#!/bin/sh
+
+# Runs 'zort' on the fixtures in this directory.  Inputs which only differ
+# in how they are given (compressed, through '<stdin>' etc.) have to produce
+# exactly the same output as the plain run on 'dir1'.
+
+cd `dirname $0` || exit 1
+zort=../zort
+tmp=/tmp/zort-tests-$$
+trap "rm -f $tmp.*" EXIT
+
+die () {
+  echo "run.sh: error: $*" 1>&2
+  exit 1
+}
+
+[ -x $zort ] || die "could not find '$zort' (run 'make' first)"
+
+run () {
+  name=$1
+  shift
+  if ! $zort "$@" > $tmp.$name 2>&1; then
+    cat $tmp.$name 1>&2
+    die "'zort $*' failed"
+  fi
+  echo "run.sh: $name"
+}
+
+same () {
+  cmp -s $tmp.$1 $tmp.$2 || die "'$1' and '$2' differ"
+}
+
+fails () {
+  name=$1
+  shift
+  $zort "$@" > $tmp.$name 2>&1 && die "'zort $*' did not fail"
+  echo "run.sh: $name"
+}
+
+contains () {
+  grep -q "$2" $tmp.$1 || die "'$1' does not contain '$2'"
+}
+
+run plain dir1
+run generated -g dir1
+run compressed compressed
+same plain compressed
+run compressed-generated -g compressed
+same generated compressed-generated
+run compressed-stdin --zummary - compressed/benchmarks.gz \
+  < compressed/zummary.xz
+same plain compressed-stdin
+
+run merge dir1 --merge merge
+contains merge "ignoring 1 zummaries in 'merge/zummary'"
+run merge-median dir1 --merge merge --reduce median
+fails merge-twice dir1 --merge merge --merge merge/zummary
+fails merge-itself dir1 --merge dir1
+run select dir1 --select 1 -b 16
+contains select "raising selection from 16 to 96 benchmarks"
+contains select "selected 96 of 400 benchmarks from 90 strata"
+run pack dir1 --pack -m 130000
+contains pack "packed into 7 buckets with at most 130000 MB each"
+fails pack-tight dir1 --pack -m 60000
+contains pack-tight "first-fit decreasing needs 7 extra buckets"
+awk 'NR == FNR { names[$3]; next } FNR == 1 || $1 in names' \
+  runlim/benchmarks dir1/zummary > $tmp.zummary
+run runlim-zummary --zummary $tmp.zummary runlim/benchmarks
+run runlim --runlim runlim
+same runlim-zummary runlim
+run runlim-generated --runlim -g runlim
+cp history/history $tmp.recorded
+run history -v dir1 --history $tmp.recorded
+contains history "read 2 runs of 401 benchmarks"
+contains history "zummary already recorded"
+cmp -s history/history $tmp.recorded || die "history of recorded run changed"
+run history-append -v --runlim runlim --history $tmp.recorded
+contains history-append "appended 48 zummaries"
+run history-appended -v --runlim runlim --history $tmp.recorded
+contains history-appended "read 3 runs of 401 benchmarks"
+contains history-appended "zummary already recorded"
@@ -26,6 +26,21 @@ static const char * usage =
 "  -m <memory>         assumed memory in MB per node (default %d MB)\n"
 "  -w <watt>           assumed Watt per core (default %d Watt)\n"
 "  -c <cents>          assumed cents per kWh (default %d cents)\n"
+"  -j <threads>        number of threads for parsing (default 1)\n"
+"  --zummary <file>    read zummary from '<file>' (use '-' for '<stdin>')\n"
+"  --runlim            read runlim logs '*.err' in directory (no 'zummary')\n"
+"  --subset            schedule listed benchmarks only (zummary is superset)\n"
+"  --predict           predict benchmarks missing in zummary (no abort)\n"
+"  --history <file>    record zummary in history and schedule by estimates\n"
+"  --calibrate <run>   rescale by zummary of new solver on benchmark subset\n"
+"  --merge <run>       merge zummary of further run (directory or file)\n"
+"  --reduce <reducer>  reduce merged runs with 'max', 'min', 'mean', 'median'\n"
+"  --cache             read and write binary cache 'zummary.cache'\n"
+"  --speed <speed|run> planned machine speed factor or fitted from run\n"
+"  --node-type <n>:<s> simulate '<n>' nodes of speed '<s>' (not with '-n')\n"
+"  --select <size>     select representative subset to calibrate (use '-g')\n"
+"  --pack              pack buckets within '-m' memory (no fast buckets)\n"
+"  --improve <seconds> improve buckets by local search within time budget\n"
 "  --euro              assume '€' as currency sign (default)\n"
 "  --dollar            assume '$' as currency sign\n"
 "\n"
@@ -68,6 +83,99 @@ static const char * usage =
 "Ultimately our objective is to minimize the running cost in terms of power\n"
 "needed for the number of allocated cores and in turn the wall-clock for\n"
 "completion of the whole array job.\n"
+"\n"
+"Both files can also be compressed with 'xz', 'gzip', 'bzip2' or 'zstd'\n"
+"(detected by their magic bytes and also found as 'zummary.xz',\n"
+"'benchmarks.gz' etc.) and are then completely decompressed into memory\n"
+"before parsing starts (thus need memory for their uncompressed size).  The\n"
+"'zummary' file can also be given explicitly with '--zummary' and then the\n"
+"directory is optional.  Using '-' or '/dev/stdin' as path reads that file\n"
+"from '<stdin>', which allows to use the tool in a pipe directly after\n"
+"'zummarize'.  Large zummaries are parsed in parallel with '-j' and with\n"
+"'--cache' parsed and matched inputs are kept in a binary cache next to the\n"
+"'zummary', which is used as long as both files do not change.\n"
+"\n"
+"With '--runlim' no 'zummary' is needed at all.  Instead the directory\n"
+"tree is scanned (in parallel with '-j') for 'runlim' logs with suffix\n"
+"'.err' which are parsed directly, using their base name as benchmark name.\n"
+"Together with '--cache' a manifest 'runlim.cache' of all parsed logs is\n"
+"kept in the directory and only new or modified logs are parsed again.\n"
+"\n"
+"Further runs of the same benchmarks (for instance with different seeds)\n"
+"can be added with '--merge' (repeatedly).  Their zummaries are merged per\n"
+"benchmark name, reducing time, real time and memory with the function\n"
+"selected by '--reduce' (default 'max') and keeping the worst status.\n"
+"Entries of benchmarks not in the first run are ignored and each file can\n"
+"only be merged once.\n"
+"\n"
+"Usually every zummary entry needs a benchmark and vice versa.  With\n"
+"'--subset' the zummary can be a superset, e.g., a global database of all\n"
+"results, and only the benchmarks listed in 'benchmarks' are scheduled.\n"
+"New benchmarks without any zummary entry are scheduled with '--predict'\n"
+"using the maximum resources of the nearest known benchmarks with respect to\n"
+"file size and the number of variables and clauses in the DIMACS header of\n"
+"the benchmark file (if a path is given).  Only benchmark files compressed\n"
+"the same way are compared.  If nothing is known about a benchmark it is\n"
+"conservatively assumed to time out.\n"
+"\n"
+"With '--history' each zummary read (but only once) is appended to the\n"
+"given history file.  Over all recorded runs an exponentially weighted\n"
+"average and the maximum of real time and memory as well as the number of\n"
+"time-outs and memory-outs is computed per benchmark.  Scheduling then uses\n"
+"the average real time and the maximum memory of the history.  This option\n"
+"can not be combined with '--merge'.\n"
+"\n"
+"To plan runs of a new solver version with the zummary of the old version\n"
+"a small calibration zummary of the new version on a subset of benchmarks\n"
+"can be given with '--calibrate'.  Per benchmark family (the alphabetic\n"
+"prefix of the benchmark name) and globally the geometric mean of the\n"
+"ratios of real time and memory between new and old version is used to\n"
+"rescale all benchmarks not in the calibration subset.  Only running times\n"
+"of solved benchmarks are rescaled, as unsolved ones still run until they\n"
+"hit the time limit, and solved ones rescaled beyond the limit time out.\n"
+"\n"
+"If the zummary was measured on a different machine than the one we plan\n"
+"for, running times can be normalized with '--speed', either by a fixed\n"
+"factor (larger than one if the planned machine is faster) or fitted from a\n"
+"zummary of the same solver on the planned machine (over the benchmarks\n"
+"solved in both).  Heterogeneous clusters are simulated by giving the\n"
+"number of nodes and their relative speed for each node type with\n"
+"'--node-type' (repeatedly).  Again only solved benchmarks are rescaled.\n"
+"\n"
+"To obtain a calibration subset for '--calibrate' (or '--speed') use\n"
+"'--select' with the desired number of benchmarks (rounded up to fill the\n"
+"last bucket).  The subset is sampled stratified by status (solved, time-out,\n"
+"memory-out or other) and the binary logarithms of real time and memory,\n"
+"giving each stratum at least one benchmark.  If there are more strata\n"
+"than requested benchmarks the subset is enlarged accordingly (with a\n"
+"message).  With '-g' or '-o' only the selected benchmarks are printed (in\n"
+"the computed bucket order), which then can directly be submitted as pilot\n"
+"job.\n"
+"\n"
+"Buckets are written longest running first, since array tasks are started\n"
+"in index order, and the execution-time span is simulated by dispatching\n"
+"them to nodes in exactly this order (with '-k' in the original order).\n"
+"\n"
+"The default scheduling only reports the maximum bucket-memory relative to\n"
+"the memory available per node ('-m').  With '--pack' this memory becomes a\n"
+"hard constraint too.  Benchmarks are then put by decreasing running time\n"
+"into the first bucket with a free core and enough free memory (first-fit\n"
+"decreasing).  As buckets are consecutive lines in the generated benchmarks\n"
+"file, all buckets except the last have to be full.  Free cores left are\n"
+"filled with benchmarks of least memory from later buckets.  Alternatively\n"
+"benchmarks are put into buckets by running time and swapped until all\n"
+"buckets respect the memory limit.  The solution with less core-time is\n"
+"used.  The number of buckets is never increased, since it is fixed by the\n"
+"number of benchmarks and the bucket-size.  If both fail the tool aborts\n"
+"instead, reporting the extra buckets and core-hours first-fit decreasing\n"
+"would need (a smaller bucket-size '-b' might help).  Fast buckets ('-f'\n"
+"and '-l') are not used in this mode.\n"
+"\n"
+"Both greedy schedules can be improved with '--improve' by local search\n"
+"within the given time budget (in seconds).  It swaps the longest running\n"
+"benchmark of a bucket with a shorter one of another bucket which runs at\n"
+"least as long, as long as memory limits and fast bucket rules are still\n"
+"respected, and reports the saved core-hours.\n"
 
 ;
 
@@ -77,13 +185,23 @@ static const char * usage =
 
 #include <assert.h>
 #include <ctype.h>
+#include <dirent.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 struct zummary;
 
@@ -91,11 +209,13 @@ struct benchmark {
   size_t number;
   char *path;
   char *name;
+  unsigned hash;
   struct zummary *zummary;
 };
 
 struct zummary {
   char *name;
+  unsigned hash;
   int status;
   double time;
   double real;
@@ -105,9 +225,8 @@ struct zummary {
     double real;
     double memory;
   } limit;
+  bool predicted;
   struct benchmark *benchmark;
-  bool scheduled;
-  bool memory_limit_hit;
 };
 
 struct bucket {
@@ -117,32 +236,247 @@ struct bucket {
   bool finished;
   double start, end;
   size_t memory_limit_hit;
-  struct zummary **zummaries;
+  unsigned *zummaries;
+};
+
+// The fields of zummaries accessed during scheduling are copied into a
+// separate structure of arrays indexed by zummary indices, while flags
+// are packed into bit-sets.  Thus the bucketing passes only stream through
+// contiguous arrays and do not touch the remaining (cold) zummary data.
+
+struct hot {
+  double *real;
+  double *memory;
+  uint64_t *solved;
+  uint64_t *limit_hit;
+  uint64_t *scheduled;
+};
+
+struct rank {
+  uint64_t key;
+  unsigned index;
+};
+
+struct index {
+  size_t mask;
+  size_t *table;
+};
+
+struct mapping {
+  char *start, *end;
+  int64_t mtime;
+  bool allocated;
+};
+
+struct compression {
+  const char *program;
+  const char *suffix;
+  size_t size;
+  const char *magic;
+};
+
+// The binary cache consists of a header, the benchmark and zummary records
+// and the string pool of all names and paths.  Strings are referenced by
+// their offset in the pool and matched records by their index.
+
+struct cached_file {
+  uint64_t size;
+  int64_t mtime;
+  uint64_t hash;
+};
+
+struct cache_header {
+  char magic[8];
+  uint64_t version;
+  struct cached_file benchmarks, zummary;
+  uint64_t size_benchmarks, size_zummaries, size_strings;
+  uint64_t subset, predict;
+  double max_memory;
+};
+
+struct cached_benchmark {
+  uint64_t number;
+  uint64_t path, name;
+  uint32_t hash, zummary;
+};
+
+struct cached_zummary {
+  uint64_t name;
+  uint32_t hash, benchmark;
+  int32_t status, predicted;
+  double time, real, memory;
+  double limit_time, limit_real, limit_memory;
+};
+
+// The manifest kept with '--runlim' and '--cache' has a similar layout.
+// It records for each log its size, modification time and parsed values,
+// sorted by the path of the log, which is again an offset into the pool.
+
+struct manifest_header {
+  char magic[8];
+  uint64_t version;
+  uint64_t size_entries, size_strings;
+};
+
+struct manifest_entry {
+  uint64_t path;
+  uint64_t size;
+  int64_t mtime;
+  int32_t state, status;
+  double time, real, memory;
+  double limit_time, limit_real, limit_memory;
+};
+
+enum error {
+  NO_ERROR,
+  EMPTY_LINE,
+  ZERO_CHARACTER,
+  MISSING_NEW_LINE,
+  TRUNCATED_LINE,
+  INVALID_ZUMMARY_LINE,
+};
+
+enum log_state {
+  UNREADABLE_LOG,
+  INCOMPLETE_LOG,
+  PARSED_LOG,
+};
+
+struct scanner {
+  pthread_mutex_t lock;
+  pthread_cond_t wakeup;
+  unsigned busy;
+  char **directories;
+  size_t size_directories, capacity_directories;
+  char **logs;
+  size_t size_logs, capacity_logs;
+  size_t next_log;
+  unsigned char *states;
+  uint64_t *sizes;
+  int64_t *mtimes;
+  const struct manifest_entry **cached;
+  size_t size_manifest;
+  bool *reused;
+};
+
+struct history {
+  char *name;
+  unsigned hash;
+  unsigned runs, timeouts, memouts;
+  double real, memory;
+  double max_real, max_memory;
+};
+
+struct family {
+  char *name;
+  unsigned hash;
+  size_t real_samples, memory_samples;
+  double real_sum, memory_sum;
+};
+
+struct node_type {
+  size_t nodes;
+  double speed;
+};
+
+struct stratum {
+  size_t start, size, selected;
+  double quota;
+};
+
+struct stratified {
+  uint64_t key;
+  double real;
+  unsigned index;
+};
+
+struct features {
+  bool size, read, header;
+  unsigned compression;
+  double bytes, variables, clauses;
+  const char *path;
+};
+
+struct neighbour {
+  double distance;
+  const struct zummary *zummary;
+};
+
+struct chunk {
+  char *start, *end;
+  size_t lineno, lines;
+  struct zummary *zummaries;
+  double max_memory;
+  enum error error;
+  size_t error_lineno;
+  pthread_t thread;
+};
+
+static struct mapping benchmarks_mapping, zummary_mapping;
+static struct mapping cache_mapping, manifest_mapping;
+static char *cache_path, *manifest_path;
+static bool use_cache;
+static bool runlim_logs;
+static bool subset;
+static bool predict;
+
+enum reducer {
+  MAX_REDUCER,
+  MIN_REDUCER,
+  MEAN_REDUCER,
+  MEDIAN_REDUCER,
 };
 
+static const char *reducer_names[] = {"max", "min", "mean", "median"};
+static enum reducer reducer;
+
+static const char *history_path;
+static struct mapping history_mapping;
+static struct history *histories;
+static size_t size_histories;
+static struct index history_index;
+static uint64_t history_hash;
+static bool history_recorded;
+
+static const char *calibration_path;
+static struct family *families;
+static size_t size_families;
+static struct index family_index;
+
+static const char **merge_paths;
+static size_t size_merge_paths;
+static uint64_t benchmarks_hash, zummary_hash;
+
 static char *line;
-static size_t size_line, capacity_line;
+static char *position, *end_of_input;
 
-static FILE *file;
 static const char *file_name;
 static size_t lineno;
 
 static struct zummary *zummaries;
 static size_t size_zummaries, capacity_zummaries;
+static unsigned *time_order, *memory_order;
+static struct hot hot;
 
 static struct benchmark *benchmarks;
 static size_t size_benchmarks, capacity_benchmarks;
 static int entries_per_benchmark_line;
 
+static struct index zummary_index;
+static struct index benchmark_index;
+static struct index number_index;
+
 static const char *benchmarks_path;
 static char *missing_benchmarks_path;
 static char *simplified_directory_path;
 static const char *directory_path;
-static char *zummary_path;
+static const char *zummary_path;
+static const char *stdin_path = "<stdin>";
 static double max_memory;
 
 static bool keep;
 static int verbosity;
+static unsigned threads;
 static bool generate;
 
 static const char *output_path;
@@ -155,6 +489,11 @@ static size_t bucket_size;
 static size_t last_bucket_size;
 static size_t tasks;
 
+static bool pack;
+static double improve_budget;
+static double *free_memory_tree;
+static size_t free_memory_leaves;
+
 static size_t max_memory_limit_hit;
 static struct bucket *buckets;
 static size_t scheduled;
@@ -162,27 +501,22 @@ static size_t scheduled;
 static size_t size_nodes;
 static struct bucket **nodes;
 
+static size_t size_selection;
+
+static double machine_speed;
+static const char *speed_path;
+static struct node_type *node_types;
+static size_t size_node_types;
+static double *node_speeds;
+
 static size_t size_memory;
 
 static bool use_euro_sign = true;
 static int watt_per_core = -1;
 static int cents_per_kwh = -1;
 
-static struct zummary *find_zummary(const char *name) {
-  for (size_t i = 0; i != size_zummaries; i++)
-    if (!strcmp(name, zummaries[i].name))
-      return zummaries + i;
-  return 0;
-}
-
-static struct benchmark *find_benchmark(const char *name) {
-  for (size_t i = 0; i != size_benchmarks; i++)
-    if (!strcmp(name, benchmarks[i].name))
-      return benchmarks + i;
-  return 0;
-}
-
-static void die(const char *, ...) __attribute__((format(printf, 1, 2)));
+static void die(const char *, ...)
+    __attribute__((noreturn, format(printf, 1, 2)));
 static void msg(const char *, ...) __attribute__((format(printf, 1, 2)));
 static void vrb(int, const char *, ...) __attribute__((format(printf, 2, 3)));
 
@@ -231,16 +565,150 @@ static void vrb(int level, const char *fmt, ...) {
 
 static void out_of_memory(const char *what) { die("out-of-memory %s", what); }
 
-static void push_char(int ch) {
-  assert(ch != EOF);
-  assert(ch != '\n');
-  if (size_line == capacity_line) {
-    capacity_line = capacity_line ? 2 * capacity_line : 1;
-    line = realloc(line, capacity_line);
-    if (!line)
-      out_of_memory("reallocating line");
+// All long-lived data of parsing and scheduling is allocated from an arena
+// of large blocks, which is released in one go at the end.  Allocations
+// larger than a quarter of the block size get their own block in order not
+// to waste the rest of the current block.
+
+#define ARENA_BLOCK_SIZE ((size_t)1 << 20)
+
+struct block {
+  struct block *next;
+  size_t size;
+};
+
+static struct block *blocks;
+static char *arena_top, *arena_end;
+
+static char *allocate_block(size_t size) {
+  struct block *block = malloc(sizeof *block + size);
+  if (!block)
+    out_of_memory("allocating arena block");
+  block->next = blocks;
+  block->size = size;
+  blocks = block;
+  return (char *)(block + 1);
+}
+
+static void *allocate(size_t bytes) {
+  bytes = (bytes + 15) & ~(size_t)15;
+  if (bytes >= ARENA_BLOCK_SIZE / 4)
+    return allocate_block(bytes);
+  if ((size_t)(arena_end - arena_top) < bytes) {
+    arena_top = allocate_block(ARENA_BLOCK_SIZE);
+    arena_end = arena_top + ARENA_BLOCK_SIZE;
+  }
+  void *res = arena_top;
+  arena_top += bytes;
+  return res;
+}
+
+static void *allocate_zeroed(size_t bytes) {
+  void *res = allocate(bytes);
+  memset(res, 0, bytes);
+  return res;
+}
+
+static char *allocate_string(const char *str) {
+  return strcpy(allocate(strlen(str) + 1), str);
+}
+
+static void release_arena(void) {
+  size_t bytes = 0;
+  for (struct block *block = blocks, *next; block; block = next) {
+    next = block->next;
+    bytes += block->size;
+    free(block);
+  }
+  vrb(1, "released %.1f MB arena", bytes / (double)(1 << 20));
+  blocks = 0;
+  arena_top = arena_end = 0;
+}
+
+static double process_time(void) {
+  struct rusage u;
+  if (getrusage(RUSAGE_SELF, &u))
+    return 0;
+  double res = u.ru_utime.tv_sec + 1e-6 * u.ru_utime.tv_usec;
+  res += u.ru_stime.tv_sec + 1e-6 * u.ru_stime.tv_usec;
+  return res;
+}
+
+static unsigned hash_string(const char *str) {
+  uint64_t res = 0;
+  unsigned char ch;
+  while ((ch = *str++))
+    res = (res + ch) * 0x9e3779b97f4a7c15ull;
+  return res >> 32;
+}
+
+// Open-addressing hash tables with linear probing over names.  Slots hold
+// the index of a benchmark respectively zummary plus one (zero is empty).
+// The hash of the name is stored in the record itself and thus compared
+// before the names are.  For duplicated names the first record is kept.
+
+static void init_index(struct index *index, size_t count) {
+  size_t size = 1;
+  while (size < 2 * count)
+    size *= 2;
+  index->mask = size - 1;
+  index->table = allocate_zeroed(size * sizeof *index->table);
+}
+
+static struct zummary *find_zummary(const char *name, unsigned hash) {
+  const size_t mask = zummary_index.mask;
+  const size_t *table = zummary_index.table;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    size_t i = table[pos];
+    if (!i)
+      return 0;
+    struct zummary *zummary = zummaries + i - 1;
+    if (zummary->hash == hash && !strcmp(zummary->name, name))
+      return zummary;
+  }
+}
+
+static struct benchmark *find_benchmark(const char *name, unsigned hash) {
+  const size_t mask = benchmark_index.mask;
+  const size_t *table = benchmark_index.table;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    size_t i = table[pos];
+    if (!i)
+      return 0;
+    struct benchmark *benchmark = benchmarks + i - 1;
+    if (benchmark->hash == hash && !strcmp(benchmark->name, name))
+      return benchmark;
+  }
+}
+
+static void index_zummaries(void) {
+  init_index(&zummary_index, size_zummaries);
+  const size_t mask = zummary_index.mask;
+  size_t *table = zummary_index.table;
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    if (find_zummary(zummary->name, zummary->hash))
+      continue;
+    size_t pos = zummary->hash & mask;
+    while (table[pos])
+      pos = (pos + 1) & mask;
+    table[pos] = i + 1;
+  }
+}
+
+static void index_benchmarks(void) {
+  init_index(&benchmark_index, size_benchmarks);
+  const size_t mask = benchmark_index.mask;
+  size_t *table = benchmark_index.table;
+  for (size_t i = 0; i != size_benchmarks; i++) {
+    struct benchmark *benchmark = benchmarks + i;
+    if (find_benchmark(benchmark->name, benchmark->hash))
+      continue;
+    size_t pos = benchmark->hash & mask;
+    while (table[pos])
+      pos = (pos + 1) & mask;
+    table[pos] = i + 1;
   }
-  line[size_line++] = ch;
 }
 
 static bool file_exists(const char *path) {
@@ -253,33 +721,304 @@ static bool directory_exists(const char *path) {
   return !stat(path, &buf) && (buf.st_mode & S_IFMT) == S_IFDIR;
 }
 
-static void init_line_reading(FILE *f, const char *name) {
-  file = f;
+static bool same_file(const char *a, const char *b) {
+  struct stat abuf, bbuf;
+  return !stat(a, &abuf) && !stat(b, &bbuf) && abuf.st_dev == bbuf.st_dev &&
+         abuf.st_ino == bbuf.st_ino;
+}
+
+// Compressed input files are detected by their magic bytes and then read
+// from the output of the corresponding decompression program.  This output
+// is not parsed incrementally but first read completely into a buffer
+// (without going through a temporary file), which is then parsed in place
+// exactly like a mapped file.
+
+static const struct compression compressions[] = {
+    {"xz", ".xz", 6, "\xFD\x37\x7A\x58\x5A\x00"},
+    {"gzip", ".gz", 2, "\x1F\x8B"},
+    {"bzip2", ".bz2", 3, "BZh"},
+    {"zstd", ".zst", 4, "\x28\xB5\x2F\xFD"},
+};
+
+#define size_compressions (sizeof compressions / sizeof *compressions)
+
+static const struct compression *match_compression(const char *magic,
+                                                    size_t bytes) {
+  for (size_t i = 0; i != size_compressions; i++) {
+    const struct compression *compression = compressions + i;
+    if (bytes >= compression->size &&
+        !memcmp(magic, compression->magic, compression->size))
+      return compression;
+  }
+  return 0;
+}
+
+static const struct compression *detect_compression(int fd) {
+  char magic[8];
+  ssize_t bytes = pread(fd, magic, sizeof magic, 0);
+  return bytes > 0 ? match_compression(magic, bytes) : 0;
+}
+
+static void read_into_memory(struct mapping *mapping, int fd,
+                             const char *path) {
+  size_t size = 0, capacity = 1 << 16;
+  char *start = malloc(capacity);
+  if (!start)
+    out_of_memory("allocating input buffer");
+  for (;;) {
+    if (size == capacity) {
+      capacity *= 2;
+      if (!(start = realloc(start, capacity)))
+        out_of_memory("reallocating input buffer");
+    }
+    ssize_t bytes = read(fd, start + size, capacity - size);
+    if (bytes < 0)
+      die("could not read '%s'", path);
+    if (!bytes)
+      break;
+    size += bytes;
+  }
+  mapping->start = start;
+  mapping->end = start + size;
+  mapping->allocated = true;
+}
+
+static void decompress_file(struct mapping *mapping, int fd, const char *path,
+                            const struct compression *compression) {
+  vrb(1, "decompressing '%s' with '%s'", path, compression->program);
+  int pipe_fds[2];
+  if (pipe(pipe_fds))
+    die("could not create pipe for decompressing '%s'", path);
+  pid_t child = fork();
+  if (child < 0)
+    die("could not fork '%s' for decompressing '%s'", compression->program,
+        path);
+  if (!child) {
+    close(pipe_fds[0]);
+    if (dup2(fd, 0) < 0 || dup2(pipe_fds[1], 1) < 0)
+      _exit(1);
+    execlp(compression->program, compression->program, "-c", "-d",
+           (char *)0);
+    _exit(1);
+  }
+  close(pipe_fds[1]);
+  read_into_memory(mapping, pipe_fds[0], path);
+  close(pipe_fds[0]);
+  int status;
+  if (waitpid(child, &status, 0) != child || !WIFEXITED(status) ||
+      WEXITSTATUS(status))
+    die("decompressing '%s' with '%s' failed", path, compression->program);
+}
+
+// Since '<stdin>' can not be rewound its magic bytes are only checked after
+// reading it into memory.  A compressed buffer is then fed by a child
+// process through a pipe to the decompression program.
+
+static void decompress_memory(struct mapping *mapping, const char *path,
+                              const struct compression *compression) {
+  int pipe_fds[2];
+  if (pipe(pipe_fds))
+    die("could not create pipe for decompressing '%s'", path);
+  pid_t child = fork();
+  if (child < 0)
+    die("could not fork for decompressing '%s'", path);
+  if (!child) {
+    close(pipe_fds[0]);
+    for (const char *p = mapping->start; p != mapping->end;) {
+      ssize_t bytes = write(pipe_fds[1], p, mapping->end - p);
+      if (bytes <= 0)
+        _exit(1);
+      p += bytes;
+    }
+    _exit(0);
+  }
+  close(pipe_fds[1]);
+  struct mapping decompressed = {0};
+  decompress_file(&decompressed, pipe_fds[0], path, compression);
+  close(pipe_fds[0]);
+  waitpid(child, 0, 0);
+  free(mapping->start);
+  *mapping = decompressed;
+}
+
+// Otherwise the whole file is mapped privately and writable, such that
+// lines and fields can be terminated in place.  In both cases names and
+// paths of benchmarks and zummaries then simply point into the mapping
+// respectively buffer and are never copied.
+
+static void map_file(struct mapping *mapping, const char *path) {
+  if (path == stdin_path) {
+    read_into_memory(mapping, 0, path);
+    const struct compression *compression =
+        match_compression(mapping->start, mapping->end - mapping->start);
+    if (compression)
+      decompress_memory(mapping, path, compression);
+    mapping->mtime = 0;
+    return;
+  }
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    die("could not open and read '%s'", path);
+  struct stat buf;
+  if (fstat(fd, &buf))
+    die("could not determine size of '%s'", path);
+  size_t size = buf.st_size;
+  const struct compression *compression = detect_compression(fd);
+  if (compression)
+    decompress_file(mapping, fd, path, compression);
+  else if (size) {
+    void *start =
+        mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (start == MAP_FAILED)
+      die("could not map '%s' to memory", path);
+    (void)madvise(start, size, MADV_SEQUENTIAL);
+    mapping->start = start;
+    mapping->end = mapping->start + size;
+  } else
+    mapping->start = mapping->end = 0;
+  mapping->mtime =
+      buf.st_mtim.tv_sec * (int64_t)1000000000 + buf.st_mtim.tv_nsec;
+  close(fd);
+}
+
+static void unmap_file(struct mapping *mapping) {
+  if (mapping->allocated)
+    free(mapping->start);
+  else if (mapping->start)
+    munmap(mapping->start, mapping->end - mapping->start);
+}
+
+static const char *normalize_stdin_path(const char *path) {
+  if (path && (!strcmp(path, "-") || !strcmp(path, "/dev/stdin")))
+    return stdin_path;
+  return path;
+}
+
+static char *directory_of(const char *path) {
+  const char *slash = strrchr(path, '/');
+  if (!slash)
+    return allocate_string(".");
+  size_t len = slash - path;
+  if (!len)
+    len = 1;
+  char *res = allocate(len + 1);
+  memcpy(res, path, len);
+  res[len] = 0;
+  return res;
+}
+
+// Input files in a directory are also found if they are compressed.
+
+static char *find_file(const char *directory, const char *name) {
+  size_t len = strlen(directory) + strlen(name) + 8;
+  char *res = allocate(len);
+  snprintf(res, len, "%s/%s", directory, name);
+  if (file_exists(res))
+    return res;
+  char *compressed = allocate(len);
+  for (size_t i = 0; i != size_compressions; i++) {
+    snprintf(compressed, len, "%s%s", res, compressions[i].suffix);
+    if (file_exists(compressed))
+      return compressed;
+  }
+  return res;
+}
+
+static void init_line_reading(struct mapping *mapping, const char *name) {
+  position = mapping->start;
+  end_of_input = mapping->end;
   file_name = name;
   lineno = 0;
 }
 
+static size_t count_lines(const char *start, const char *end) {
+  size_t res = 0;
+  for (const char *p = start; p != end && (p = memchr(p, '\n', end - p)); p++)
+    res++;
+  if (start != end && end[-1] != '\n')
+    res++;
+  return res;
+}
+
+static void line_error(enum error error, size_t lineno, const char *name) {
+  switch (error) {
+  case EMPTY_LINE:
+    die("empty line %zu in '%s'", lineno, name);
+  case ZERO_CHARACTER:
+    die("unexpected zero character in line %zu in '%s'", lineno, name);
+  case MISSING_NEW_LINE:
+    die("unexpected end-of-file before new-line in line %zu in '%s'", lineno,
+        name);
+  case TRUNCATED_LINE:
+    die("line %zu truncated in '%s'", lineno, name);
+  case INVALID_ZUMMARY_LINE:
+    die("invalid zummary line %zu in '%s'", lineno, name);
+  default:
+    assert(error == NO_ERROR);
+  }
+}
+
+static enum error split_line(char **position_ptr, char *end, char **line_ptr) {
+  char *p = *position_ptr;
+  assert(p != end);
+  if (*p == '\n')
+    return EMPTY_LINE;
+  size_t bytes = end - p;
+  char *q = memchr(p, '\n', bytes);
+  if (memchr(p, 0, q ? (size_t)(q - p) : bytes))
+    return ZERO_CHARACTER;
+  if (!q)
+    return MISSING_NEW_LINE;
+  *q = 0;
+  *line_ptr = p;
+  *position_ptr = q + 1;
+  return NO_ERROR;
+}
+
 static bool read_line(void) {
-  int ch = fgetc(file);
-  if (ch == EOF)
+  if (position == end_of_input)
     return false;
   lineno++;
-  if (ch == '\n')
-    die("empty line %zu in '%s'", lineno, file_name);
-  size_line = 0;
-  push_char(ch);
-  while ((ch = fgetc(file)) != '\n')
-    if (ch == EOF)
-      die("unexpected end-of-file before new-line in line %zu in '%s'", lineno,
-          file_name);
-    else if (!ch)
-      die("unexpected zero character in line %zu in '%s'", lineno, file_name);
-    else
-      push_char(ch);
-  push_char(0);
+  enum error error = split_line(&position, end_of_input, &line);
+  if (error)
+    line_error(error, lineno, file_name);
   return true;
 }
 
+// Benchmark numbers are kept in a hash table too, which is allocated for
+// the number of lines before parsing, in order to detect duplicated numbers
+// without rescanning all previous benchmarks.  The table is keyed by the
+// number itself and thus works for dense and sparse numbering alike.
+
+static unsigned hash_number(size_t number) {
+  return ((uint64_t)number * 0x9e3779b97f4a7c15ull) >> 32;
+}
+
+static void insert_benchmark_number(size_t number, size_t i) {
+  const size_t mask = number_index.mask;
+  size_t *table = number_index.table;
+  size_t pos = hash_number(number) & mask;
+  while (table[pos])
+    pos = (pos + 1) & mask;
+  table[pos] = i + 1;
+}
+
+static void index_benchmark_number(size_t number) {
+  assert(size_benchmarks < capacity_benchmarks);
+  const size_t mask = number_index.mask;
+  const size_t *table = number_index.table;
+  for (size_t pos = hash_number(number) & mask;; pos = (pos + 1) & mask) {
+    size_t i = table[pos];
+    if (!i)
+      break;
+    if (benchmarks[i - 1].number == number)
+      die("benchmark number %zu at line %zu in '%s' "
+          "already used at line %zu",
+          number, size_benchmarks + 1, file_name, i);
+  }
+  insert_benchmark_number(number, size_benchmarks);
+}
+
 static void determine_entries_per_benchmark_line(void) {
   assert(!entries_per_benchmark_line);
   const char *p = line;
@@ -315,11 +1054,7 @@ static void parse_benchmark2(struct benchmark *benchmark) {
     else
       number = 10 * number + (ch - '0');
   benchmark->number = number;
-  for (size_t i = 0; i != size_benchmarks; i++)
-    if (benchmarks[i].number == number)
-      die("benchmark number %zu at line %zu in '%s' "
-          "already used at line %zu",
-          number, size_benchmarks + 1, file_name, i + 1);
+  index_benchmark_number(number);
   char *q = p;
   while ((ch = *p))
     if (ch == ' ')
@@ -327,183 +1062,2749 @@ static void parse_benchmark2(struct benchmark *benchmark) {
     else
       p++;
   benchmark->path = 0;
-  if (!(benchmark->name = strdup(q)))
-    out_of_memory("copying benchmark name");
+  benchmark->name = q;
+  benchmark->hash = hash_string(q);
+}
+
+static void parse_benchmark3(struct benchmark *benchmark) {
+  char *p = line;
+  size_t number = 0;
+  if (!isdigit(*p))
+  EXPECTED_DIGIT:
+    die("expected digit in line %zu in '%s'", lineno, file_name);
+  char ch;
+  while ((ch = *p++) != ' ')
+    if (!isdigit(ch))
+      goto EXPECTED_DIGIT;
+    else
+      number = 10 * number + (ch - '0');
+  benchmark->number = number;
+  index_benchmark_number(number);
+  char *q = p;
+  while ((ch = *p) != ' ')
+    if (!ch)
+      die("line %zu truncated in '%s'", lineno, file_name);
+    else
+      p++;
+  *p++ = 0;
+  benchmark->path = q;
+  benchmark->name = p;
+  benchmark->hash = hash_string(p);
+}
+
+static void parse_benchmark(struct benchmark *benchmark) {
+  if (!entries_per_benchmark_line)
+    determine_entries_per_benchmark_line();
+  if (entries_per_benchmark_line == 2)
+    parse_benchmark2(benchmark);
+  else
+    parse_benchmark3(benchmark);
+}
+
+static void push_benchmark(struct benchmark *benchmark) {
+  assert(size_benchmarks < capacity_benchmarks);
+  benchmarks[size_benchmarks++] = *benchmark;
+}
+
+// Fast path for parsing the numbers of a zummary line, which only accepts
+// plain decimal numbers separated by single spaces.  Doubles with at most
+// 19 significant digits, a mantissa fitting into 53 bits and a decimal
+// exponent of at most 22 are computed with one multiplication or division
+// of two exactly representable doubles, which is correctly rounded and thus
+// gives the same result as 'strtod'.  For everything else 'false' is
+// returned and the caller falls back to 'sscanf'.
+
+static const double powers_of_ten[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static const char *parse_int(const char *p, int *res) {
+  bool negative = false;
+  if (*p == '-')
+    negative = true, p++;
+  else if (*p == '+')
+    p++;
+  if (!isdigit(*p))
+    return 0;
+  int digits = 0, value = 0;
+  while (isdigit(*p)) {
+    if (++digits > 9)
+      return 0;
+    value = 10 * value + (*p++ - '0');
+  }
+  *res = negative ? -value : value;
+  return p;
+}
+
+static const char *parse_double(const char *p, double *res) {
+  bool negative = false;
+  if (*p == '-')
+    negative = true, p++;
+  else if (*p == '+')
+    p++;
+  uint64_t mantissa = 0;
+  int significant = 0, exponent = 0, digits = 0;
+  while (isdigit(*p)) {
+    digits++;
+    if (mantissa || *p != '0') {
+      if (++significant > 19)
+        return 0;
+      mantissa = 10 * mantissa + (*p - '0');
+    }
+    p++;
+  }
+  if (*p == '.') {
+    p++;
+    while (isdigit(*p)) {
+      digits++;
+      if (mantissa || *p != '0') {
+        if (++significant > 19)
+          return 0;
+        mantissa = 10 * mantissa + (*p - '0');
+      }
+      exponent--;
+      p++;
+    }
+  }
+  if (!digits)
+    return 0;
+  if (*p == 'e' || *p == 'E') {
+    p++;
+    bool negative_exponent = false;
+    if (*p == '-')
+      negative_exponent = true, p++;
+    else if (*p == '+')
+      p++;
+    if (!isdigit(*p))
+      return 0;
+    int explicit_exponent = 0;
+    while (isdigit(*p)) {
+      if (explicit_exponent > 1000)
+        return 0;
+      explicit_exponent = 10 * explicit_exponent + (*p++ - '0');
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  if (mantissa > ((uint64_t)1 << 53))
+    return 0;
+  double value = mantissa;
+  if (mantissa && exponent < 0) {
+    if (exponent < -22)
+      return 0;
+    value /= powers_of_ten[-exponent];
+  } else if (mantissa && exponent > 0) {
+    if (exponent > 22)
+      return 0;
+    value *= powers_of_ten[exponent];
+  }
+  *res = negative ? -value : value;
+  return p;
+}
+
+static bool parse_zummary_numbers(const char *p, struct zummary *zummary) {
+  double *fields[6] = {&zummary->time,       &zummary->real,
+                       &zummary->memory,     &zummary->limit.time,
+                       &zummary->limit.real, &zummary->limit.memory};
+  if (!(p = parse_int(p, &zummary->status)))
+    return false;
+  for (unsigned i = 0; i != 6; i++) {
+    if (*p++ != ' ')
+      return false;
+    if (!(p = parse_double(p, fields[i])))
+      return false;
+  }
+  return !*p;
+}
+
+static enum error parse_zummary_line(char *line, struct zummary *zummary) {
+  char *p = line, ch;
+  while ((ch = *p) != ' ')
+    if (!ch)
+      return TRUNCATED_LINE;
+    else
+      p++;
+  *p++ = 0;
+  zummary->name = line;
+  zummary->hash = hash_string(line);
+  zummary->predicted = false;
+  if (!parse_zummary_numbers(p, zummary) &&
+      sscanf(p, "%d %lf %lf %lf %lf %lf %lf", &zummary->status, &zummary->time,
+             &zummary->real, &zummary->memory, &zummary->limit.time,
+             &zummary->limit.real, &zummary->limit.memory) != 7)
+    return INVALID_ZUMMARY_LINE;
+  return NO_ERROR;
+}
+
+static void parse_zummary(struct zummary *zummary) {
+  enum error error = parse_zummary_line(line, zummary);
+  if (error)
+    line_error(error, lineno, file_name);
+  if (max_memory < zummary->memory)
+    max_memory = zummary->memory;
+}
+
+static void push_zummary(struct zummary *zummary) {
+  assert(size_zummaries < capacity_zummaries);
+  zummaries[size_zummaries++] = *zummary;
+}
+
+// Parallel parsing of the remaining zummary lines splits the input into
+// chunks ending at new-lines.  In a first parallel phase the lines in each
+// chunk are counted, which gives the line number and record offset of each
+// chunk.  In the second phase each thread parses its chunk directly into
+// the final zummaries array.  Threads do not abort on errors but record
+// them, such that the first error in line order is reported with the
+// correct line number, exactly as in sequential parsing.
+
+static void *count_chunk(void *ptr) {
+  struct chunk *chunk = ptr;
+  chunk->lines = count_lines(chunk->start, chunk->end);
+  return 0;
+}
+
+static void *parse_chunk(void *ptr) {
+  struct chunk *chunk = ptr;
+  double max_memory = 0;
+  char *p = chunk->start, *line;
+  for (size_t i = 0; i != chunk->lines; i++) {
+    enum error error = split_line(&p, chunk->end, &line);
+    if (!error)
+      error = parse_zummary_line(line, chunk->zummaries + i);
+    if (error) {
+      chunk->error = error;
+      chunk->error_lineno = chunk->lineno + i + 1;
+      break;
+    }
+    if (max_memory < chunk->zummaries[i].memory)
+      max_memory = chunk->zummaries[i].memory;
+  }
+  chunk->max_memory = max_memory;
+  return 0;
+}
+
+static void run_chunks(struct chunk *chunks, unsigned size,
+                       void *(*function)(void *)) {
+  for (unsigned i = 0; i != size; i++)
+    if (pthread_create(&chunks[i].thread, 0, function, chunks + i))
+      die("failed to create parser thread");
+  for (unsigned i = 0; i != size; i++)
+    if (pthread_join(chunks[i].thread, 0))
+      die("failed to join parser thread");
+}
+
+static void parse_zummaries_in_parallel(void) {
+  assert(threads > 1);
+  assert(!size_zummaries);
+  size_t bytes = end_of_input - position;
+  unsigned size = threads;
+  const size_t min_chunk_size = 1 << 16;
+  if (bytes / min_chunk_size + 1 < size)
+    size = bytes / min_chunk_size + 1;
+  struct chunk *chunks = calloc(size, sizeof *chunks);
+  if (!chunks)
+    out_of_memory("allocating chunks");
+  char *start = position;
+  for (unsigned i = 0; i != size; i++) {
+    struct chunk *chunk = chunks + i;
+    char *end = position + (i + 1) * (bytes / size);
+    if (i + 1 == size)
+      end = end_of_input;
+    else if (end <= start)
+      end = start;
+    else {
+      char *p = memchr(end - 1, '\n', end_of_input - end + 1);
+      end = p ? p + 1 : end_of_input;
+    }
+    chunk->start = start;
+    chunk->end = end;
+    start = end;
+  }
+  vrb(1, "parsing zummaries with %u threads in %u chunks", threads, size);
+  run_chunks(chunks, size, count_chunk);
+  size_t lines = 0;
+  for (unsigned i = 0; i != size; i++) {
+    struct chunk *chunk = chunks + i;
+    chunk->lineno = lineno + lines;
+    lines += chunk->lines;
+  }
+  if (lines > UINT_MAX)
+    die("too many zummaries in '%s'", file_name);
+  zummaries = allocate(lines * sizeof *zummaries);
+  for (unsigned i = 0; i != size; i++)
+    chunks[i].zummaries = zummaries + (chunks[i].lineno - lineno);
+  run_chunks(chunks, size, parse_chunk);
+  for (unsigned i = 0; i != size; i++) {
+    struct chunk *chunk = chunks + i;
+    line_error(chunk->error, chunk->error_lineno, file_name);
+    if (max_memory < chunk->max_memory)
+      max_memory = chunk->max_memory;
+  }
+  size_zummaries = capacity_zummaries = lines;
+  lineno += lines;
+  position = end_of_input;
+  free(chunks);
+}
+
+// With '--runlim' zummaries are not read from a 'zummary' file but built
+// directly from the 'runlim' logs (files with suffix '.err') found in the
+// directory tree, similar to what 'zummarize' does.  First the directory
+// tree is traversed in parallel by a pool of threads sharing a stack of
+// directories still to be scanned.  Then the found logs are sorted by path
+// and parsed in parallel, with each thread claiming the next log to parse.
+// The name of the zummary is the base name of its log without suffix.
+
+#define RUNLIM_LOG_SUFFIX ".err"
+
+static struct scanner scanner;
+
+static void push_string(char ***strings_ptr, size_t *size_ptr,
+                        size_t *capacity_ptr, char *str) {
+  if (*size_ptr == *capacity_ptr) {
+    *capacity_ptr = *capacity_ptr ? 2 * *capacity_ptr : 16;
+    *strings_ptr = realloc(*strings_ptr, *capacity_ptr * sizeof **strings_ptr);
+    if (!*strings_ptr)
+      out_of_memory("reallocating scanned paths");
+  }
+  (*strings_ptr)[(*size_ptr)++] = str;
+}
+
+static bool has_suffix(const char *str, const char *suffix) {
+  size_t len = strlen(str), suffix_len = strlen(suffix);
+  return len > suffix_len && !strcmp(str + len - suffix_len, suffix);
+}
+
+static void scan_directory(const char *directory) {
+  DIR *dir = opendir(directory);
+  if (!dir) {
+    msg("could not open directory '%s'", directory);
+    return;
+  }
+  char **directories = 0, **logs = 0;
+  size_t size_directories = 0, capacity_directories = 0;
+  size_t size_logs = 0, capacity_logs = 0;
+  size_t directory_len = strlen(directory);
+  struct dirent *entry;
+  while ((entry = readdir(dir))) {
+    const char *name = entry->d_name;
+    if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+      continue;
+    bool is_directory = entry->d_type == DT_DIR;
+    bool is_file = entry->d_type == DT_REG;
+    if (!is_directory && !is_file && entry->d_type != DT_LNK &&
+        entry->d_type != DT_UNKNOWN)
+      continue;
+    if (!is_directory && !has_suffix(name, RUNLIM_LOG_SUFFIX) &&
+        entry->d_type != DT_UNKNOWN)
+      continue;
+    size_t len = directory_len + strlen(name) + 2;
+    char *path = malloc(len);
+    if (!path)
+      out_of_memory("allocating scanned path");
+    snprintf(path, len, "%s/%s", directory, name);
+    if (entry->d_type == DT_UNKNOWN) {
+      struct stat buf;
+      if (!lstat(path, &buf))
+        is_directory = S_ISDIR(buf.st_mode), is_file = S_ISREG(buf.st_mode);
+    } else if (entry->d_type == DT_LNK)
+      is_file = file_exists(path);
+    if (is_directory)
+      push_string(&directories, &size_directories, &capacity_directories,
+                  path);
+    else if (is_file && has_suffix(name, RUNLIM_LOG_SUFFIX))
+      push_string(&logs, &size_logs, &capacity_logs, path);
+    else
+      free(path);
+  }
+  closedir(dir);
+  pthread_mutex_lock(&scanner.lock);
+  for (size_t i = 0; i != size_directories; i++) {
+    push_string(&scanner.directories, &scanner.size_directories,
+                &scanner.capacity_directories,
+                allocate_string(directories[i]));
+    free(directories[i]);
+  }
+  for (size_t i = 0; i != size_logs; i++) {
+    push_string(&scanner.logs, &scanner.size_logs, &scanner.capacity_logs,
+                allocate_string(logs[i]));
+    free(logs[i]);
+  }
+  pthread_mutex_unlock(&scanner.lock);
+  free(directories);
+  free(logs);
+}
+
+static void *scan_directories(void *ptr) {
+  (void)ptr;
+  pthread_mutex_lock(&scanner.lock);
+  for (;;) {
+    while (!scanner.size_directories && scanner.busy)
+      pthread_cond_wait(&scanner.wakeup, &scanner.lock);
+    if (!scanner.size_directories)
+      break;
+    char *directory = scanner.directories[--scanner.size_directories];
+    scanner.busy++;
+    pthread_mutex_unlock(&scanner.lock);
+    scan_directory(directory);
+    pthread_mutex_lock(&scanner.lock);
+    scanner.busy--;
+    pthread_cond_broadcast(&scanner.wakeup);
+  }
+  pthread_cond_broadcast(&scanner.wakeup);
+  pthread_mutex_unlock(&scanner.lock);
+  return 0;
+}
+
+static double runlim_seconds(const char *value) {
+  return strtod(value, 0);
+}
+
+// Maps the 'runlim' status and result to the status used in zummaries,
+// i.e., '10' and '20' for solved instances, '1' for time-outs, '2' for
+// memory-outs and '0' for everything else.
+
+static int runlim_status(const char *status, int result) {
+  if (!strcmp(status, "ok"))
+    return (result == 10 || result == 20) ? result : 0;
+  if (!strcmp(status, "out of time"))
+    return 1;
+  if (!strcmp(status, "out of memory"))
+    return 2;
+  return 0;
+}
+
+// With '--cache' a manifest 'runlim.cache' is kept in the directory and
+// only logs with a different size or modification time than recorded in
+// the manifest (or not recorded at all) are read and parsed again.
+
+#define MANIFEST_NAME "runlim.cache"
+#define MANIFEST_MAGIC "ZORTRLIM"
+#define MANIFEST_VERSION 1
+
+static void load_manifest(void) {
+  size_t manifest_path_len =
+      strlen(directory_path) + strlen("/" MANIFEST_NAME) + 1;
+  manifest_path = allocate(manifest_path_len);
+  snprintf(manifest_path, manifest_path_len, "%s/" MANIFEST_NAME,
+           directory_path);
+  if (!file_exists(manifest_path)) {
+    vrb(1, "manifest '%s' does not exist yet", manifest_path);
+    return;
+  }
+  int fd = open(manifest_path, O_RDONLY);
+  if (fd < 0) {
+    vrb(1, "could not open manifest '%s'", manifest_path);
+    return;
+  }
+  struct stat buf;
+  if (fstat(fd, &buf) ||
+      (size_t)buf.st_size < sizeof(struct manifest_header)) {
+    close(fd);
+    vrb(1, "ignoring invalid manifest '%s'", manifest_path);
+    return;
+  }
+  size_t size = buf.st_size;
+  void *start = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (start == MAP_FAILED) {
+    vrb(1, "could not map manifest '%s' to memory", manifest_path);
+    return;
+  }
+  manifest_mapping.start = start;
+  manifest_mapping.end = manifest_mapping.start + size;
+  const struct manifest_header *header = start;
+  const struct manifest_entry *entries = (void *)(header + 1);
+  const char *strings = (void *)(entries + header->size_entries);
+  size_t size_entries = header->size_entries;
+  if (memcmp(header->magic, MANIFEST_MAGIC, sizeof header->magic) ||
+      header->version != MANIFEST_VERSION ||
+      size_entries > size / sizeof *entries ||
+      sizeof *header + size_entries * sizeof *entries +
+              header->size_strings !=
+          size ||
+      (header->size_strings && strings[header->size_strings - 1])) {
+    vrb(1, "ignoring invalid manifest '%s'", manifest_path);
+    return;
+  }
+  for (size_t i = 0; i != size_entries; i++)
+    if (entries[i].path >= header->size_strings) {
+      vrb(1, "ignoring corrupted manifest '%s'", manifest_path);
+      return;
+    }
+  scanner.size_manifest = size_entries;
+  size_t size_logs = scanner.size_logs, found = 0;
+  scanner.cached = allocate_zeroed(size_logs * sizeof *scanner.cached);
+  for (size_t i = 0, j = 0; i != size_logs && j != size_entries;) {
+    int cmp = strcmp(strings + entries[j].path, scanner.logs[i]);
+    if (cmp < 0)
+      j++;
+    else if (cmp > 0)
+      i++;
+    else
+      scanner.cached[i++] = entries + j++, found++;
+  }
+  vrb(1, "found %zu of %zu logs in manifest '%s'", found, size_logs,
+      manifest_path);
+}
+
+static void load_manifest_entry(const struct manifest_entry *entry,
+                                struct zummary *zummary) {
+  memset(zummary, 0, sizeof *zummary);
+  zummary->status = entry->status;
+  zummary->time = entry->time;
+  zummary->real = entry->real;
+  zummary->memory = entry->memory;
+  zummary->limit.time = entry->limit_time;
+  zummary->limit.real = entry->limit_real;
+  zummary->limit.memory = entry->limit_memory;
+}
+
+static void write_manifest(void) {
+  size_t tmp_path_len = strlen(manifest_path) + strlen(".tmp") + 1;
+  char *tmp_path = allocate(tmp_path_len);
+  snprintf(tmp_path, tmp_path_len, "%s.tmp", manifest_path);
+  FILE *file = fopen(tmp_path, "w");
+  if (!file) {
+    msg("could not write manifest '%s'", tmp_path);
+    return;
+  }
+  struct manifest_header header;
+  memset(&header, 0, sizeof header);
+  memcpy(header.magic, MANIFEST_MAGIC, sizeof header.magic);
+  header.version = MANIFEST_VERSION;
+  size_t size_logs = scanner.size_logs;
+  for (size_t i = 0; i != size_logs; i++)
+    if (scanner.states[i] != UNREADABLE_LOG) {
+      header.size_entries++;
+      header.size_strings += strlen(scanner.logs[i]) + 1;
+    }
+  bool written = fwrite(&header, sizeof header, 1, file) == 1;
+  uint64_t offset = 0;
+  for (size_t i = 0; written && i != size_logs; i++) {
+    if (scanner.states[i] == UNREADABLE_LOG)
+      continue;
+    const struct zummary *zummary = zummaries + i;
+    struct manifest_entry e;
+    memset(&e, 0, sizeof e);
+    e.path = offset;
+    offset += strlen(scanner.logs[i]) + 1;
+    e.size = scanner.sizes[i];
+    e.mtime = scanner.mtimes[i];
+    e.state = scanner.states[i];
+    e.status = zummary->status;
+    e.time = zummary->time;
+    e.real = zummary->real;
+    e.memory = zummary->memory;
+    e.limit_time = zummary->limit.time;
+    e.limit_real = zummary->limit.real;
+    e.limit_memory = zummary->limit.memory;
+    written = fwrite(&e, sizeof e, 1, file) == 1;
+  }
+  for (size_t i = 0; written && i != size_logs; i++)
+    if (scanner.states[i] != UNREADABLE_LOG)
+      written = fputs(scanner.logs[i], file) != EOF && fputc(0, file) != EOF;
+  if (fclose(file))
+    written = false;
+  if (written && !rename(tmp_path, manifest_path))
+    vrb(1, "wrote manifest '%s'", manifest_path);
+  else {
+    msg("could not write manifest '%s'", manifest_path);
+    unlink(tmp_path);
+  }
+}
+
+static bool parse_runlim_log(char *start, char *end,
+                             struct zummary *zummary) {
+  bool has_status = false, has_real = false, has_space = false;
+  char status[64] = "";
+  int result = 0;
+  memset(zummary, 0, sizeof *zummary);
+  for (char *p = start, *q; p != end; p = q + 1) {
+    q = memchr(p, '\n', end - p);
+    if (!q)
+      q = end;
+    *q = 0;
+    const char *prefix = "[runlim] ";
+    size_t prefix_len = strlen(prefix);
+    if (strncmp(p, prefix, prefix_len))
+      continue;
+    char *key = p + prefix_len;
+    char *colon = strchr(key, ':');
+    if (!colon)
+      continue;
+    *colon = 0;
+    char *value = colon + 1;
+    while (*value == ' ' || *value == '\t')
+      value++;
+    if (!strcmp(key, "time limit"))
+      zummary->limit.time = runlim_seconds(value);
+    else if (!strcmp(key, "real time limit"))
+      zummary->limit.real = runlim_seconds(value);
+    else if (!strcmp(key, "space limit"))
+      zummary->limit.memory = strtod(value, 0);
+    else if (!strcmp(key, "status")) {
+      snprintf(status, sizeof status, "%s", value);
+      has_status = true;
+    } else if (!strcmp(key, "result"))
+      result = atoi(value);
+    else if (!strcmp(key, "real")) {
+      zummary->real = runlim_seconds(value);
+      has_real = true;
+    } else if (!strcmp(key, "time"))
+      zummary->time = runlim_seconds(value);
+    else if (!strcmp(key, "space")) {
+      zummary->memory = strtod(value, 0);
+      has_space = true;
+    }
+    if (q == end)
+      break;
+  }
+  zummary->status = runlim_status(status, result);
+  return has_status && has_real && has_space;
+}
+
+static void *parse_runlim_logs_thread(void *ptr) {
+  (void)ptr;
+  size_t capacity = 1 << 16;
+  char *buffer = malloc(capacity);
+  if (!buffer)
+    out_of_memory("allocating log buffer");
+  for (;;) {
+    size_t i = __atomic_fetch_add(&scanner.next_log, 1, __ATOMIC_RELAXED);
+    if (i >= scanner.size_logs)
+      break;
+    int fd = open(scanner.logs[i], O_RDONLY);
+    if (fd < 0)
+      continue;
+    struct stat buf;
+    if (fstat(fd, &buf)) {
+      close(fd);
+      continue;
+    }
+    scanner.sizes[i] = buf.st_size;
+    scanner.mtimes[i] =
+        buf.st_mtim.tv_sec * (int64_t)1000000000 + buf.st_mtim.tv_nsec;
+    struct zummary *zummary = zummaries + i;
+    const struct manifest_entry *entry =
+        scanner.cached ? scanner.cached[i] : 0;
+    if (entry && entry->size == scanner.sizes[i] &&
+        entry->mtime == scanner.mtimes[i] && entry->state != UNREADABLE_LOG) {
+      close(fd);
+      load_manifest_entry(entry, zummary);
+      scanner.states[i] = entry->state;
+      scanner.reused[i] = true;
+      continue;
+    }
+    size_t size = 0;
+    ssize_t bytes;
+    for (;;) {
+      if (size == capacity) {
+        capacity *= 2;
+        if (!(buffer = realloc(buffer, capacity)))
+          out_of_memory("reallocating log buffer");
+      }
+      if ((bytes = read(fd, buffer + size, capacity - size)) <= 0)
+        break;
+      size += bytes;
+    }
+    close(fd);
+    if (bytes < 0)
+      continue;
+    scanner.states[i] = parse_runlim_log(buffer, buffer + size, zummary)
+                            ? PARSED_LOG
+                            : INCOMPLETE_LOG;
+  }
+  free(buffer);
+  return 0;
+}
+
+static int compare_strings(const void *p, const void *q) {
+  return strcmp(*(char *const *)p, *(char *const *)q);
+}
+
+static void run_threads(unsigned size, void *(*function)(void *)) {
+  pthread_t *pool = malloc(size * sizeof *pool);
+  if (!pool)
+    out_of_memory("allocating thread pool");
+  for (unsigned i = 0; i != size; i++)
+    if (pthread_create(pool + i, 0, function, 0))
+      die("failed to create thread");
+  for (unsigned i = 0; i != size; i++)
+    if (pthread_join(pool[i], 0))
+      die("failed to join thread");
+  free(pool);
+}
+
+static void parse_runlim_logs(void) {
+  double start = process_time();
+  unsigned size = threads ? threads : 1;
+  pthread_mutex_init(&scanner.lock, 0);
+  pthread_cond_init(&scanner.wakeup, 0);
+  push_string(&scanner.directories, &scanner.size_directories,
+              &scanner.capacity_directories, (char *)directory_path);
+  run_threads(size, scan_directories);
+  pthread_cond_destroy(&scanner.wakeup);
+  pthread_mutex_destroy(&scanner.lock);
+  size_t size_logs = scanner.size_logs;
+  vrb(1, "found %zu runlim logs in '%s' with %u threads", size_logs,
+      directory_path, size);
+  if (size_logs > UINT_MAX)
+    die("too many runlim logs in '%s'", directory_path);
+  qsort(scanner.logs, size_logs, sizeof *scanner.logs, compare_strings);
+  if (use_cache)
+    load_manifest();
+  zummaries = allocate(size_logs * sizeof *zummaries);
+  scanner.states = allocate_zeroed(size_logs * sizeof *scanner.states);
+  scanner.sizes = allocate_zeroed(size_logs * sizeof *scanner.sizes);
+  scanner.mtimes = allocate_zeroed(size_logs * sizeof *scanner.mtimes);
+  scanner.reused = allocate_zeroed(size_logs * sizeof *scanner.reused);
+  run_threads(size, parse_runlim_logs_thread);
+  size_t reused = 0;
+  for (size_t i = 0; i != size_logs; i++)
+    reused += scanner.reused[i];
+  if (use_cache) {
+    vrb(1, "reused %zu and parsed %zu runlim logs", reused,
+        size_logs - reused);
+    if (reused != size_logs || reused != scanner.size_manifest)
+      write_manifest();
+  }
+  for (size_t i = 0; i != size_logs; i++) {
+    if (scanner.states[i] != PARSED_LOG) {
+      vrb(1, "ignoring incomplete runlim log '%s'", scanner.logs[i]);
+      continue;
+    }
+    struct zummary *zummary = zummaries + i;
+    char *name = strrchr(scanner.logs[i], '/');
+    name = name ? name + 1 : scanner.logs[i];
+    name[strlen(name) - strlen(RUNLIM_LOG_SUFFIX)] = 0;
+    zummary->name = name;
+    zummary->hash = hash_string(name);
+    if (max_memory < zummary->memory)
+      max_memory = zummary->memory;
+    zummaries[size_zummaries++] = *zummary;
+  }
+  capacity_zummaries = size_logs;
+  free(scanner.directories);
+  free(scanner.logs);
+  vrb(1, "parsed %zu zummaries from runlim logs in %.2f seconds",
+      size_zummaries, process_time() - start);
+}
+
+// Sorting uses a stable least-significant-digit radix sort on pairs of
+// 64-bit keys and indices.  Doubles are mapped to keys which preserve
+// their order.  Sorting with respect to the secondary key first and then
+// with respect to the primary key yields the lexicographic order needed.
+// Byte positions in which all keys agree are skipped.
+
+static uint64_t rank_double(double d) {
+  if (!d)
+    d = 0; // Make sure '-0.0' and '0.0' get the same key.
+  uint64_t res;
+  memcpy(&res, &d, sizeof res);
+  const uint64_t sign = (uint64_t)1 << 63;
+  return (res & sign) ? ~res : res | sign;
+}
+
+static void radix_sort_ranks(size_t size, struct rank *ranks) {
+  uint64_t lower = ~(uint64_t)0, upper = 0;
+  for (size_t i = 0; i != size; i++)
+    lower &= ranks[i].key, upper |= ranks[i].key;
+  const uint64_t varying = upper & ~lower;
+  if (!varying)
+    return;
+  struct rank *tmp = malloc(size * sizeof *tmp);
+  if (!tmp)
+    out_of_memory("allocating radix sort buffer");
+  struct rank *a = ranks, *b = tmp;
+  for (unsigned shift = 0; shift != 64; shift += 8) {
+    if (!((varying >> shift) & 255))
+      continue;
+    size_t count[256];
+    memset(count, 0, sizeof count);
+    for (size_t i = 0; i != size; i++)
+      count[(a[i].key >> shift) & 255]++;
+    size_t pos = 0;
+    for (unsigned digit = 0; digit != 256; digit++) {
+      size_t delta = count[digit];
+      count[digit] = pos;
+      pos += delta;
+    }
+    for (size_t i = 0; i != size; i++)
+      b[count[(a[i].key >> shift) & 255]++] = a[i];
+    struct rank *c = a;
+    a = b, b = c;
+  }
+  if (a != ranks)
+    memcpy(ranks, a, size * sizeof *ranks);
+  free(tmp);
+}
+
+// Zummaries are not moved while sorting.  Instead a permutation of their
+// indices is computed, which orders them with respect to either memory or
+// time as primary key and the other one as secondary key.  Thus pointers
+// to zummaries stay valid and several orderings can be used side by side.
+
+static unsigned *sort_zummaries(bool by_memory) {
+  assert(size_zummaries);
+  assert(size_zummaries <= UINT_MAX);
+  struct rank *ranks = malloc(size_zummaries * sizeof *ranks);
+  if (!ranks)
+    out_of_memory("allocating zummary ranks");
+  for (size_t i = 0; i != size_zummaries; i++) {
+    double secondary = by_memory ? hot.real[i] : hot.memory[i];
+    ranks[i].key = rank_double(secondary);
+    ranks[i].index = i;
+  }
+  radix_sort_ranks(size_zummaries, ranks);
+  for (size_t i = 0; i != size_zummaries; i++) {
+    unsigned idx = ranks[i].index;
+    double primary = by_memory ? hot.memory[idx] : hot.real[idx];
+    ranks[i].key = rank_double(primary);
+  }
+  radix_sort_ranks(size_zummaries, ranks);
+  unsigned *order = allocate(size_zummaries * sizeof *order);
+  for (size_t i = 0; i != size_zummaries; i++)
+    order[i] = ranks[i].index;
+  free(ranks);
+  return order;
+}
+
+static unsigned *sort_zummaries_by_memory(void) { return sort_zummaries(true); }
+
+static unsigned *sort_zummaries_by_time(void) { return sort_zummaries(false); }
+
+// Array tasks are dispatched by SLURM in index order, i.e., in the order
+// the buckets are written.  Writing them in longest-processing-time-first
+// order (stable for ties) gives a much better makespan than the previous
+// shortest-first simulation order and the node simulation then uses
+// exactly this order too.  Since a bucket consists of consecutive lines in
+// the written benchmarks file, buckets which are not full have to be
+// written last, as otherwise the following buckets would be shifted.
+
+static void sort_buckets_by_decreasing_real(void) {
+  assert(tasks);
+  struct rank *ranks = malloc(tasks * sizeof *ranks);
+  struct bucket *sorted = malloc(tasks * sizeof *sorted);
+  if (!ranks || !sorted)
+    out_of_memory("allocating bucket ranks");
+  for (size_t i = 0; i != tasks; i++) {
+    ranks[i].key = ~rank_double(buckets[i].real);
+    ranks[i].index = i;
+  }
+  radix_sort_ranks(tasks, ranks);
+  for (size_t i = 0; i != tasks; i++)
+    ranks[i].key = buckets[ranks[i].index].size < bucket_size;
+  radix_sort_ranks(tasks, ranks);
+  for (size_t i = 0; i != tasks; i++)
+    sorted[i] = buckets[ranks[i].index];
+  memcpy(buckets, sorted, tasks * sizeof *buckets);
+  free(sorted);
+  free(ranks);
+}
+
+static bool get_bit(const uint64_t *bits, size_t i) {
+  return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+static void set_bit(uint64_t *bits, size_t i) {
+  bits[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static uint64_t *new_bits(size_t size) {
+  return allocate_zeroed((size + 63) / 64 * sizeof(uint64_t));
+}
+
+static void init_hot(void) {
+  hot.real = allocate(size_zummaries * sizeof *hot.real);
+  hot.memory = allocate(size_zummaries * sizeof *hot.memory);
+  hot.solved = new_bits(size_zummaries);
+  hot.limit_hit = new_bits(size_zummaries);
+  hot.scheduled = new_bits(size_zummaries);
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    hot.real[i] = zummary->real;
+    hot.memory[i] = zummary->memory;
+    if (zummary->status == 10 || zummary->status == 20)
+      set_bit(hot.solved, i);
+    if (zummary->status == 2 || zummary->memory >= zummary->limit.memory)
+      set_bit(hot.limit_hit, i);
+  }
+}
+
+static void schedule_zummary(struct bucket *bucket, unsigned idx) {
+  assert(!get_bit(hot.scheduled, idx));
+  assert(bucket->size < bucket_size);
+  bucket->zummaries[bucket->size++] = idx;
+  if (bucket->real < hot.real[idx])
+    bucket->real = hot.real[idx];
+  bucket->memory += hot.memory[idx];
+  if (get_bit(hot.limit_hit, idx)) {
+    bucket->memory_limit_hit++;
+    if (max_memory_limit_hit < bucket->memory_limit_hit)
+      max_memory_limit_hit = bucket->memory_limit_hit;
+  }
+  set_bit(hot.scheduled, idx);
+  scheduled++;
+}
+
+static size_t next_bucket(size_t j) {
+  assert(j < tasks);
+  size_t res = j;
+  for (;;) {
+    if (++res == tasks)
+      res = 0;
+    size_t max_size = (res + 1 == tasks) ? last_bucket_size : bucket_size;
+    if (buckets[res].size < max_size)
+      return res;
+  }
+}
+
+static void update_bucket(struct bucket *bucket) {
+  bucket->real = bucket->memory = 0;
+  bucket->memory_limit_hit = 0;
+  for (size_t i = 0; i != bucket->size; i++) {
+    unsigned idx = bucket->zummaries[i];
+    if (bucket->real < hot.real[idx])
+      bucket->real = hot.real[idx];
+    bucket->memory += hot.memory[idx];
+    bucket->memory_limit_hit += get_bit(hot.limit_hit, idx);
+  }
+}
+
+// With '--pack' cores per bucket and the memory per node '-m' are both
+// treated as hard constraints.  Benchmarks are considered by decreasing
+// real time (and decreasing memory for ties) and each is put into the
+// first bucket with a free core and enough free memory (first-fit
+// decreasing), such that benchmarks with similar running time still end up
+// in the same bucket.  The first fitting bucket is found in logarithmic
+// time with a maximum segment tree over the free memory of all potential
+// buckets, where full buckets have negative free memory.  The search can
+// also start at a given bucket, which allows to enumerate all buckets with
+// enough free memory without visiting the others.
+
+#define INVALID_BUCKET (~(size_t)0)
+
+static void update_free_memory(size_t bucket, double free) {
+  double *tree = free_memory_tree;
+  size_t i = free_memory_leaves + bucket;
+  tree[i] = free;
+  while (i >>= 1)
+    tree[i] = tree[2 * i] > tree[2 * i + 1] ? tree[2 * i] : tree[2 * i + 1];
+}
+
+static double free_memory(const struct bucket *bucket) {
+  double res = size_memory - bucket->memory;
+  return bucket->size == bucket_size || res < 0 ? -1 : res;
+}
+
+static size_t find_free_bucket(size_t start, double memory) {
+  const double *tree = free_memory_tree;
+  if (start >= free_memory_leaves)
+    return INVALID_BUCKET;
+  size_t i = free_memory_leaves + start;
+  while (tree[i] < memory) {
+    while (i & 1)
+      if (!(i >>= 1))
+        return INVALID_BUCKET;
+    i++;
+  }
+  while (i < free_memory_leaves) {
+    i *= 2;
+    if (tree[i] < memory)
+      i++;
+  }
+  return i - free_memory_leaves;
+}
+
+// Buckets are consecutive lines in the generated benchmarks file and thus
+// all buckets except the last one have to be full, while first-fit
+// decreasing leaves free cores in buckets running out of memory.  These
+// are filled in bucket order with the benchmarks of least memory in later
+// buckets, which are found by walking the memory order once.  If such a
+// benchmark does not fit, the benchmark with most memory of the bucket is
+// first moved to the first later bucket where it fits (or a new one).
+// Emptied buckets at the end are dropped.  This fails if the benchmarks of
+// the bucket need less memory than those left and still leave too little.
+
+static size_t most_memory(const struct bucket *bucket) {
+  size_t res = 0;
+  for (size_t i = 1; i < bucket->size; i++)
+    if (hot.memory[bucket->zummaries[i]] > hot.memory[bucket->zummaries[res]])
+      res = i;
+  return res;
+}
+
+static void move_zummary(size_t *owners, size_t *slots, size_t to,
+                         unsigned idx) {
+  struct bucket *bucket = buckets + owners[idx];
+  unsigned last = bucket->zummaries[--bucket->size];
+  bucket->zummaries[slots[idx]] = last;
+  slots[last] = slots[idx];
+  update_bucket(bucket);
+  update_free_memory(owners[idx], free_memory(bucket));
+  bucket = buckets + to;
+  if (!bucket->zummaries)
+    bucket->zummaries = allocate(bucket_size * sizeof *bucket->zummaries);
+  slots[idx] = bucket->size;
+  owners[idx] = to;
+  bucket->zummaries[bucket->size++] = idx;
+  update_bucket(bucket);
+  update_free_memory(to, free_memory(bucket));
+}
+
+static bool fill_packed_buckets(size_t *used_ptr) {
+  size_t used = *used_ptr;
+  size_t *owners = allocate(size_zummaries * sizeof *owners);
+  size_t *slots = allocate(size_zummaries * sizeof *slots);
+  for (size_t i = 0; i != used; i++)
+    for (size_t j = 0; j != buckets[i].size; j++) {
+      unsigned idx = buckets[i].zummaries[j];
+      owners[idx] = i, slots[idx] = j;
+    }
+  size_t next = 0;
+  bool res = true;
+  for (size_t i = 0; res && i + 1 < used; i++) {
+    struct bucket *bucket = buckets + i;
+    while (bucket->size < bucket_size && i + 1 < used) {
+      while (owners[memory_order[next]] <= i)
+        next++;
+      unsigned idx = memory_order[next];
+      if (bucket->memory + hot.memory[idx] > size_memory) {
+        unsigned largest = bucket->zummaries[most_memory(bucket)];
+        if (hot.memory[largest] <= hot.memory[idx]) {
+          res = false;
+          break;
+        }
+        update_free_memory(i, -1);
+        size_t to = find_free_bucket(0, hot.memory[largest]);
+        if (to == INVALID_BUCKET) {
+          res = false;
+          break;
+        }
+        if (to == used)
+          used++;
+        move_zummary(owners, slots, to, largest);
+      }
+      move_zummary(owners, slots, i, idx);
+      update_free_memory(i, -1);
+      while (!buckets[used - 1].size)
+        used--;
+    }
+  }
+  *used_ptr = used;
+  return res;
+}
+
+// Alternatively benchmarks are put into the minimum number of buckets by
+// decreasing running time and then, as long as a bucket exceeds the memory
+// limit, its benchmark with most memory is swapped with a benchmark of less
+// memory and most similar running time in a bucket which then still
+// respects the limit.  Each swap reduces the memory exceeding the limit and
+// thus this repair terminates.  We keep the solution with less core-time.
+// The segment tree then holds the memory left below the limit per bucket.
+// A swap partner of 'x' has less memory, thus at most the largest memory
+// below that of 'x', and only buckets with at least the difference left
+// are enumerated through the tree.
+
+static double memory_below(unsigned x) {
+  size_t lower = 0, upper = size_zummaries;
+  while (lower < upper) {
+    size_t middle = lower + (upper - lower) / 2;
+    if (hot.memory[memory_order[middle]] < hot.memory[x])
+      lower = middle + 1;
+    else
+      upper = middle;
+  }
+  return lower ? hot.memory[memory_order[lower - 1]] : -1;
+}
+
+static double sum_real(size_t size) {
+  double res = 0;
+  for (size_t i = 0; i != size; i++)
+    res += buckets[i].real;
+  return res;
+}
+
+static bool repair_buckets(size_t minimum) {
+  for (size_t i = 0, j = 0; i != minimum; i++) {
+    struct bucket *bucket = buckets + i;
+    if (!bucket->zummaries)
+      bucket->zummaries = allocate(bucket_size * sizeof *bucket->zummaries);
+    size_t size = i + 1 == minimum ? last_bucket_size : bucket_size;
+    for (bucket->size = 0; bucket->size != size; j++)
+      bucket->zummaries[bucket->size++] = time_order[size_zummaries - j - 1];
+    update_bucket(bucket);
+  }
+  for (size_t i = 0; i != free_memory_leaves; i++)
+    update_free_memory(i, i < minimum ? size_memory - buckets[i].memory : -1);
+  size_t swaps = 0;
+  for (size_t a = 0; a != minimum; a++) {
+    struct bucket *bucket = buckets + a;
+    while (bucket->memory > size_memory) {
+      size_t position = most_memory(bucket);
+      unsigned x = bucket->zummaries[position];
+      double below = memory_below(x);
+      if (below < 0)
+        return false;
+      double needed = hot.memory[x] - below;
+      struct bucket *other = 0;
+      size_t other_position = 0;
+      double best = HUGE_VAL;
+      for (size_t b = find_free_bucket(0, needed); b < minimum;
+           b = find_free_bucket(b + 1, needed)) {
+        struct bucket *candidate = buckets + b;
+        assert(b != a);
+        for (size_t i = 0; i != candidate->size; i++) {
+          unsigned y = candidate->zummaries[i];
+          if (hot.memory[y] >= hot.memory[x] ||
+              candidate->memory - hot.memory[y] + hot.memory[x] > size_memory)
+            continue;
+          double distance = fabs(hot.real[x] - hot.real[y]);
+          if (distance >= best)
+            continue;
+          best = distance;
+          other = candidate, other_position = i;
+        }
+      }
+      if (!other)
+        return false;
+      bucket->zummaries[position] = other->zummaries[other_position];
+      other->zummaries[other_position] = x;
+      update_bucket(bucket);
+      update_bucket(other);
+      update_free_memory(a, size_memory - bucket->memory);
+      update_free_memory(other - buckets, size_memory - other->memory);
+      swaps++;
+    }
+  }
+  vrb(1, "repaired memory of buckets with %zu swaps", swaps);
+  return true;
+}
+
+static void pack_buckets(void) {
+  const size_t minimum = tasks, capacity = size_zummaries;
+  buckets = allocate_zeroed(capacity * sizeof *buckets);
+  size_t leaves = 1;
+  while (leaves < capacity)
+    leaves *= 2;
+  free_memory_leaves = leaves;
+  free_memory_tree = allocate(2 * leaves * sizeof *free_memory_tree);
+  double *tree = free_memory_tree;
+  for (size_t i = 0; i != leaves; i++)
+    tree[leaves + i] = i < capacity ? (double)size_memory : -1;
+  for (size_t i = leaves - 1; i; i--)
+    tree[i] = tree[2 * i] > tree[2 * i + 1] ? tree[2 * i] : tree[2 * i + 1];
+  memory_order = sort_zummaries_by_memory();
+  size_t used = 0, oversized = 0;
+  for (size_t i = size_zummaries; i--;) {
+    unsigned idx = time_order[i];
+    size_t j = find_free_bucket(0, hot.memory[idx]);
+    if (j == INVALID_BUCKET) {
+      vrb(1, "benchmark '%s' alone exceeds %zu MB memory",
+          zummaries[idx].name, size_memory);
+      j = used;
+      oversized++;
+    }
+    assert(j <= used);
+    struct bucket *bucket = buckets + j;
+    if (j == used) {
+      bucket->zummaries = allocate(bucket_size * sizeof *bucket->zummaries);
+      used++;
+    }
+    schedule_zummary(bucket, idx);
+    update_free_memory(j, free_memory(bucket));
+  }
+  vrb(1, "first-fit decreasing packed into %zu buckets (%zu extra buckets)",
+      used, used - minimum);
+  if (oversized)
+    msg("%zu benchmarks alone exceed available memory of %zu MB", oversized,
+        size_memory);
+  const size_t packed = used;
+  double chunked = 0;
+  for (size_t i = 0; i < size_zummaries; i += bucket_size)
+    chunked += hot.real[time_order[size_zummaries - i - 1]];
+  const double packed_hours = bucket_size * (sum_real(used) - chunked) / 3600;
+  bool filled = fill_packed_buckets(&used);
+  struct bucket *filled_buckets = 0;
+  unsigned *filled_zummaries = 0;
+  double filled_real = 0;
+  if (filled) {
+    assert(used == minimum);
+    filled_real = sum_real(minimum);
+    filled_buckets = allocate(minimum * sizeof *filled_buckets);
+    memcpy(filled_buckets, buckets, minimum * sizeof *buckets);
+    filled_zummaries = allocate(size_zummaries * sizeof *filled_zummaries);
+    for (size_t i = 0, j = 0; i != minimum; j += buckets[i++].size)
+      memcpy(filled_zummaries + j, buckets[i].zummaries,
+             buckets[i].size * sizeof *filled_zummaries);
+  } else
+    vrb(1, "could not fill first-fit decreasing buckets");
+  if (repair_buckets(minimum) && (!filled || sum_real(minimum) < filled_real))
+    vrb(1, "using repaired buckets ordered by running time");
+  else if (filled) {
+    memcpy(buckets, filled_buckets, minimum * sizeof *buckets);
+    for (size_t i = 0, j = 0; i != minimum; j += buckets[i++].size)
+      memcpy(buckets[i].zummaries, filled_zummaries + j,
+             buckets[i].size * sizeof *filled_zummaries);
+    vrb(1, "using filled first-fit decreasing buckets");
+  } else if (packed > minimum)
+    die("could not pack benchmarks into %zu buckets within %zu MB "
+        "(first-fit decreasing needs %zu extra buckets and %.2f more "
+        "core-hours, try a smaller bucket-size '-b')",
+        minimum, size_memory, packed - minimum, packed_hours);
+  else
+    die("could not pack benchmarks into %zu buckets within %zu MB", minimum,
+        size_memory);
+  used = minimum;
+  tasks = used;
+  max_memory_limit_hit = 0;
+  for (size_t i = 0; i != used; i++)
+    if (max_memory_limit_hit < buckets[i].memory_limit_hit)
+      max_memory_limit_hit = buckets[i].memory_limit_hit;
+  msg("packed into %zu buckets with at most %zu MB each", used, size_memory);
+}
+
+// With '--improve <seconds>' the buckets computed by the greedy passes are
+// improved by local search within the given time budget (process time),
+// in order to reduce the sum of maximum running times per bucket, which
+// determines the allocated core-time.  For each bucket we try to swap its
+// longest running benchmark with a shorter one in another bucket with at
+// least the same maximum running time, picking the swap which reduces the
+// maximum running time of the first bucket the most.  If no swap reduces it
+// (e.g., due to ties) we still swap with a bucket of larger maximum running
+// time (or the same but smaller index), which moves long running benchmarks
+// to buckets which run that long anyhow.  As these swaps do not change the
+// maximum running times of buckets, but move running time to buckets of
+// higher rank, the search terminates.  Only swaps are used,
+// since buckets are consecutive lines in the benchmarks file and thus their
+// sizes are fixed.  A swap may neither raise bucket memory above the memory
+// limit (or the maximum bucket memory of the greedy solution if larger)
+// nor put a benchmark into a fast bucket which is not solved or exceeds
+// the fast bucket memory limit.
+
+static bool fast_bucket_eligible(unsigned idx) {
+  return get_bit(hot.solved, idx) && hot.memory[idx] <= fast_bucket_memory;
+}
+
+static bool memory_respected(const struct bucket *bucket, double memory,
+                             double limit) {
+  return memory <= limit || memory <= bucket->memory;
+}
+
+static void improve_buckets(void) {
+  if (!improve_budget || tasks < 2)
+    return;
+  double start = process_time(), deadline = start + improve_budget;
+  double before = 0, limit = size_memory;
+  for (size_t i = 0; i != tasks; i++) {
+    before += buckets[i].real;
+    if (!pack && limit < buckets[i].memory)
+      limit = buckets[i].memory;
+  }
+  bool *fast = allocate_zeroed(tasks * sizeof *fast);
+  size_t fast_buckets = pack ? 0 : (fast_bucket_fraction * tasks) / 100u;
+  for (size_t i = 0; i != fast_buckets; i++) {
+    const struct bucket *bucket = buckets + i;
+    fast[i] = true;
+    for (size_t j = 0; fast[i] && j != bucket->size; j++)
+      fast[i] = fast_bucket_eligible(bucket->zummaries[j]);
+  }
+  size_t swaps = 0, checked = 0;
+  bool improved = true, timeout = false;
+  while (improved && !timeout) {
+    improved = false;
+    for (size_t a = 0; !timeout && a != tasks; a++) {
+      struct bucket *bucket = buckets + a;
+      if (bucket->size < 2)
+        continue;
+      size_t longest = 0;
+      for (size_t i = 1; i != bucket->size; i++)
+        if (hot.real[bucket->zummaries[i]] >
+            hot.real[bucket->zummaries[longest]])
+          longest = i;
+      unsigned x = bucket->zummaries[longest];
+      double real = hot.real[x], second = 0;
+      for (size_t i = 0; i != bucket->size; i++)
+        if (i != longest && second < hot.real[bucket->zummaries[i]])
+          second = hot.real[bucket->zummaries[i]];
+      double best_gain = 0, best_shift = 0;
+      struct bucket *other = 0;
+      size_t position = 0;
+      for (size_t b = 0; b != tasks; b++) {
+        struct bucket *candidate = buckets + b;
+        if (b == a || candidate->real < real)
+          continue;
+        if (fast[b] && !fast_bucket_eligible(x))
+          continue;
+        bool higher = candidate->real > bucket->real ||
+                      (candidate->real == bucket->real && b < a);
+        for (size_t i = 0; i != candidate->size; i++) {
+          unsigned y = candidate->zummaries[i];
+          if (hot.real[y] >= real || (fast[a] && !fast_bucket_eligible(y)))
+            continue;
+          double gain = real - (hot.real[y] > second ? hot.real[y] : second);
+          if (gain <= 0 && !higher)
+            continue;
+          double shift = real - hot.real[y];
+          if (gain < best_gain || (gain == best_gain && shift <= best_shift))
+            continue;
+          double delta = hot.memory[y] - hot.memory[x];
+          if (!memory_respected(bucket, bucket->memory + delta, limit) ||
+              !memory_respected(candidate, candidate->memory - delta, limit))
+            continue;
+          best_gain = gain, best_shift = shift;
+          other = candidate, position = i;
+        }
+        if (!(++checked & 255) && process_time() >= deadline) {
+          timeout = true;
+          break;
+        }
+      }
+      if (!other)
+        continue;
+      bucket->zummaries[longest] = other->zummaries[position];
+      other->zummaries[position] = x;
+      update_bucket(bucket);
+      update_bucket(other);
+      improved = true;
+      swaps++;
+    }
+  }
+  double after = 0;
+  max_memory_limit_hit = 0;
+  for (size_t i = 0; i != tasks; i++) {
+    after += buckets[i].real;
+    if (max_memory_limit_hit < buckets[i].memory_limit_hit)
+      max_memory_limit_hit = buckets[i].memory_limit_hit;
+  }
+  double gain = bucket_size * (before - after) / 3600;
+  msg("local search %s after %zu swaps saved %.2f core-hours in %.2f seconds",
+      timeout ? "stopped" : "completed", swaps, gain, process_time() - start);
+}
+
+static const char *simplify_directory_path(const char *directory_path) {
+  size_t len = strlen(directory_path);
+  if (!len || directory_path[len - 1] != '/')
+    return directory_path;
+  simplified_directory_path = allocate_string(directory_path);
+  char *p = simplified_directory_path + len - 1;
+  while (p != simplified_directory_path && *p == '/')
+    p--;
+  p[1] = 0;
+  return simplified_directory_path;
+}
+
+static void parse_benchmarks(void) {
+  size_t lines = count_lines(benchmarks_mapping.start, benchmarks_mapping.end);
+  benchmarks = allocate(lines * sizeof *benchmarks);
+  capacity_benchmarks = lines;
+  init_index(&number_index, lines);
+  init_line_reading(&benchmarks_mapping, benchmarks_path);
+  while (read_line()) {
+    struct benchmark benchmark;
+    parse_benchmark(&benchmark);
+    push_benchmark(&benchmark);
+  }
+  if (!size_benchmarks)
+    die("could not find any benchmark in '%s'", benchmarks_path);
+  vrb(1, "parsed %zu benchmarks in '%s'", size_benchmarks, benchmarks_path);
+}
+
+static void parse_zummaries(void) {
+  init_line_reading(&zummary_mapping, zummary_path);
+  if (!read_line())
+    die("failed to read header line in '%s'", zummary_path);
+  if (threads > 1)
+    parse_zummaries_in_parallel();
+  else {
+    size_t lines = count_lines(position, end_of_input);
+    if (lines > UINT_MAX)
+      die("too many zummaries in '%s'", zummary_path);
+    zummaries = allocate(lines * sizeof *zummaries);
+    capacity_zummaries = lines;
+    while (read_line()) {
+      struct zummary zummary;
+      parse_zummary(&zummary);
+      push_zummary(&zummary);
+    }
+  }
+  vrb(1, "parsed %zu zummaries in '%s'", size_zummaries, zummary_path);
+}
+
+// With '--subset' the zummary may contain more entries than benchmarks
+// listed, e.g., if it is a global database of all benchmarks ever run.
+// Then only benchmarks are looked up in the zummary index and afterwards
+// the zummaries are compacted to the matched ones (keeping their order).
+
+static void compact_zummaries(void) {
+  size_t size_matched = 0;
+  max_memory = 0;
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    struct benchmark *benchmark = zummary->benchmark;
+    if (!benchmark)
+      continue;
+    struct zummary *matched = zummaries + size_matched++;
+    *matched = *zummary;
+    benchmark->zummary = matched;
+    if (max_memory < matched->memory)
+      max_memory = matched->memory;
+  }
+  vrb(1, "scheduling subset of %zu out of %zu zummaries", size_matched,
+      size_zummaries);
+  size_zummaries = size_matched;
+  index_zummaries();
+}
+
+// With '--predict' benchmarks without zummary entry get a predicted one
+// instead of aborting.  Features are the logarithms of the file size and
+// of the number of variables and clauses in the DIMACS header, which is
+// read lazily from the start of the (possibly compressed) benchmark file.
+// Known benchmarks are sorted by file size and only the headers of those
+// closest in file size to a missing benchmark are read (once).  Sizes of
+// files compressed differently are not comparable, thus the sorted sizes
+// are partitioned by compression and candidates only taken from the part
+// with the same compression as the missing benchmark.  Among these
+// candidates the prediction takes the maximum real time, time and memory
+// of the nearest ones.  Without features or neighbours we assume
+// conservatively a time-out with the maximum memory seen so far.
+
+#define PREDICTION_NEIGHBOURS 5
+#define PREDICTION_CANDIDATES 32
+#define HEADER_PREFIX_SIZE (1 << 16)
+
+static const char *benchmark_file(const struct benchmark *benchmark) {
+  const char *path = benchmark->path;
+  if (!path || path[0] == '/' || file_exists(path) ||
+      benchmarks_path == stdin_path)
+    return path;
+  char *directory = directory_of(benchmarks_path);
+  size_t len = strlen(directory) + strlen(path) + 2;
+  char *res = allocate(len);
+  snprintf(res, len, "%s/%s", directory, path);
+  return res;
+}
+
+static size_t read_prefix(const char *path, char *buffer, size_t size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  const struct compression *compression = detect_compression(fd);
+  ssize_t bytes;
+  if (!compression) {
+    bytes = read(fd, buffer, size);
+    close(fd);
+    return bytes < 0 ? 0 : bytes;
+  }
+  int pipe_fds[2];
+  pid_t child = -1;
+  if (!pipe(pipe_fds) && (child = fork()) < 0) {
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+  }
+  if (child < 0) {
+    close(fd);
+    return 0;
+  }
+  if (!child) {
+    close(pipe_fds[0]);
+    int null = open("/dev/null", O_WRONLY);
+    if (dup2(fd, 0) < 0 || dup2(pipe_fds[1], 1) < 0 ||
+        (null >= 0 && dup2(null, 2) < 0))
+      _exit(1);
+    execlp(compression->program, compression->program, "-c", "-d",
+           (char *)0);
+    _exit(1);
+  }
+  close(fd);
+  close(pipe_fds[1]);
+  size_t res = 0;
+  while (res < size &&
+         (bytes = read(pipe_fds[0], buffer + res, size - res)) > 0)
+    res += bytes;
+  close(pipe_fds[0]);
+  kill(child, SIGTERM);
+  waitpid(child, 0, 0);
+  return res;
+}
+
+static bool parse_dimacs_header(const char *p, const char *end,
+                                double *variables, double *clauses) {
+  const char *q;
+  while (p != end && (q = memchr(p, '\n', end - p))) {
+    if (*p == 'p') {
+      char header[128];
+      size_t len = q - p;
+      if (len >= sizeof header)
+        len = sizeof header - 1;
+      memcpy(header, p, len);
+      header[len] = 0;
+      long v, c;
+      if (sscanf(header, "p cnf %ld %ld", &v, &c) != 2 || v < 0 || c < 0)
+        return false;
+      *variables = v, *clauses = c;
+      return true;
+    }
+    if (*p != 'c' && p != q)
+      return false;
+    p = q + 1;
+  }
+  return false;
+}
+
+static void size_feature(const struct benchmark *benchmark,
+                         struct features *features) {
+  memset(features, 0, sizeof *features);
+  const char *path = benchmark_file(benchmark);
+  struct stat buf;
+  if (!path || stat(path, &buf) || !S_ISREG(buf.st_mode))
+    return;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return;
+  const struct compression *compression = detect_compression(fd);
+  close(fd);
+  features->compression = compression ? compression - compressions + 1 : 0;
+  features->path = path;
+  features->size = true;
+  features->bytes = log(1.0 + buf.st_size);
+}
+
+static bool header_features(struct features *features, char *buffer) {
+  if (!features->size || features->read)
+    return false;
+  features->read = true;
+  size_t size = read_prefix(features->path, buffer, HEADER_PREFIX_SIZE);
+  double variables, clauses;
+  if (!parse_dimacs_header(buffer, buffer + size, &variables, &clauses))
+    return true;
+  features->header = true;
+  features->variables = log(1.0 + variables);
+  features->clauses = log(1.0 + clauses);
+  return true;
+}
+
+static double feature_distance(const struct features *a,
+                               const struct features *b) {
+  double res = (a->bytes - b->bytes) * (a->bytes - b->bytes);
+  if (a->header && b->header) {
+    res += (a->variables - b->variables) * (a->variables - b->variables);
+    res += (a->clauses - b->clauses) * (a->clauses - b->clauses);
+  }
+  return res;
+}
+
+static void insert_neighbour(struct neighbour *neighbours, size_t *size_ptr,
+                             double distance, const struct zummary *zummary) {
+  size_t k = *size_ptr;
+  if (k == PREDICTION_NEIGHBOURS) {
+    if (neighbours[k - 1].distance <= distance)
+      return;
+    k--;
+  } else
+    ++*size_ptr;
+  while (k && neighbours[k - 1].distance > distance)
+    neighbours[k] = neighbours[k - 1], k--;
+  neighbours[k].distance = distance;
+  neighbours[k].zummary = zummary;
+}
+
+static void predict_zummaries(size_t missing) {
+  size_t size_known = size_zummaries;
+  if (!size_known)
+    die("can not predict %zu missing zummaries without any known zummary",
+        missing);
+  double start = process_time();
+  char *buffer = malloc(HEADER_PREFIX_SIZE);
+  if (!buffer)
+    out_of_memory("allocating header buffer");
+  struct zummary *known = zummaries;
+  struct features *features = allocate(size_known * sizeof *features);
+  struct rank *sizes = malloc(size_known * sizeof *sizes);
+  if (!sizes)
+    out_of_memory("allocating file sizes");
+  size_t size_sizes = 0;
+  double max_real = 0;
+  for (size_t i = 0; i != size_known; i++) {
+    size_feature(known[i].benchmark, features + i);
+    if (features[i].size) {
+      sizes[size_sizes].key = rank_double(features[i].bytes);
+      sizes[size_sizes++].index = i;
+    }
+    if (max_real < known[i].limit.real)
+      max_real = known[i].limit.real;
+    if (max_real < known[i].real)
+      max_real = known[i].real;
+  }
+  radix_sort_ranks(size_sizes, sizes);
+  size_t starts[size_compressions + 2];
+  memset(starts, 0, sizeof starts);
+  for (size_t i = 0; i != size_sizes; i++)
+    starts[features[sizes[i].index].compression + 1]++;
+  for (size_t c = 1; c != size_compressions + 2; c++)
+    starts[c] += starts[c - 1];
+  struct rank *sorted = malloc(size_known * sizeof *sorted);
+  if (!sorted)
+    out_of_memory("allocating sorted file sizes");
+  size_t positions[size_compressions + 1];
+  memcpy(positions, starts, sizeof positions);
+  for (size_t i = 0; i != size_sizes; i++)
+    sorted[positions[features[sizes[i].index].compression]++] = sizes[i];
+  free(sizes);
+  sizes = sorted;
+  zummaries = allocate((size_known + missing) * sizeof *zummaries);
+  memcpy(zummaries, known, size_known * sizeof *zummaries);
+  capacity_zummaries = size_known + missing;
+  for (size_t i = 0; i != size_known; i++)
+    zummaries[i].benchmark->zummary = zummaries + i;
+  size_t conservative = 0, headers = 0;
+  for (size_t i = 0; i != size_benchmarks; i++) {
+    struct benchmark *benchmark = benchmarks + i;
+    if (benchmark->zummary)
+      continue;
+    struct features target;
+    size_feature(benchmark, &target);
+    headers += header_features(&target, buffer);
+    struct neighbour neighbours[PREDICTION_NEIGHBOURS];
+    size_t size_neighbours = 0;
+    if (target.size) {
+      uint64_t key = rank_double(target.bytes);
+      const size_t first = starts[target.compression];
+      const size_t last = starts[target.compression + 1];
+      size_t lower = first, upper = last;
+      while (lower < upper) {
+        size_t middle = lower + (upper - lower) / 2;
+        if (sizes[middle].key < key)
+          lower = middle + 1;
+        else
+          upper = middle;
+      }
+      upper = lower;
+      for (size_t k = 0; k != PREDICTION_CANDIDATES; k++) {
+        size_t pos;
+        if (lower != first &&
+            (upper == last ||
+             target.bytes - features[sizes[lower - 1].index].bytes <
+                 features[sizes[upper].index].bytes - target.bytes))
+          pos = --lower;
+        else if (upper != last)
+          pos = upper++;
+        else
+          break;
+        unsigned j = sizes[pos].index;
+        headers += header_features(features + j, buffer);
+        double distance = feature_distance(&target, features + j);
+        insert_neighbour(neighbours, &size_neighbours, distance, zummaries + j);
+      }
+    }
+    struct zummary *zummary = zummaries + size_zummaries++;
+    memset(zummary, 0, sizeof *zummary);
+    zummary->name = benchmark->name;
+    zummary->hash = benchmark->hash;
+    zummary->predicted = true;
+    zummary->benchmark = benchmark;
+    benchmark->zummary = zummary;
+    zummary->limit = known[0].limit;
+    if (size_neighbours) {
+      zummary->limit = neighbours[0].zummary->limit;
+      for (size_t k = 0; k != size_neighbours; k++) {
+        const struct zummary *neighbour = neighbours[k].zummary;
+        if (zummary->time < neighbour->time)
+          zummary->time = neighbour->time;
+        if (zummary->real < neighbour->real)
+          zummary->real = neighbour->real;
+        if (zummary->memory < neighbour->memory)
+          zummary->memory = neighbour->memory;
+      }
+    } else {
+      zummary->status = 1;
+      zummary->time = zummary->real = max_real;
+      zummary->memory = max_memory;
+      conservative++;
+    }
+    vrb(2, "predicted real %.2f seconds and memory %.0f MB for '%s'",
+        zummary->real, zummary->memory, zummary->name);
+  }
+  for (size_t i = size_known; i != size_zummaries; i++)
+    if (max_memory < zummaries[i].memory)
+      max_memory = zummaries[i].memory;
+  free(sizes);
+  free(buffer);
+  index_zummaries();
+  vrb(1, "read %zu DIMACS headers of %zu known and %zu missing benchmarks",
+      headers, size_known, missing);
+  msg("predicted %zu missing zummaries (%zu conservatively) in %.2f seconds",
+      missing, conservative, process_time() - start);
+}
+
+static void match_zummaries(void) {
+  double matching_start = process_time();
+  index_benchmarks();
+  index_zummaries();
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    if (subset) {
+      zummary->benchmark = 0;
+      continue;
+    }
+    struct benchmark *benchmark = find_benchmark(zummary->name, zummary->hash);
+    if (!benchmark)
+      die("could not find zummary entry '%s' in benchmarks", zummary->name);
+    zummary->benchmark = benchmark;
+  }
+  size_t missing = 0;
+  for (size_t i = 0; i != size_benchmarks; i++) {
+    struct benchmark *benchmark = benchmarks + i;
+    struct zummary *zummary = find_zummary(benchmark->name, benchmark->hash);
+    if (!zummary && predict) {
+      benchmark->zummary = 0;
+      missing++;
+      continue;
+    }
+    if (!zummary)
+      die("could not find benchmark entry '%s' in zummary", benchmark->name);
+    benchmark->zummary = zummary;
+    if (subset)
+      zummary->benchmark = benchmark;
+  }
+  if (subset)
+    compact_zummaries();
+  if (missing)
+    predict_zummaries(missing);
+  vrb(1, "matched benchmarks and zummaries in %.2f seconds",
+      process_time() - matching_start);
+  if (size_benchmarks == size_zummaries)
+    vrb(1, "zummaries and benchmarks match (found %zu of both)",
+        size_zummaries);
+  else
+    die("%zu benchmarks different from %zu zummaries", size_benchmarks,
+        size_zummaries);
+}
+
+// With '--merge' the zummaries of further runs (for instance with other
+// seeds) are aggregated per benchmark with those read first.  Each further
+// zummary is streamed line by line and its records are looked up by name
+// in the zummary hash index.  Time, real time and memory are reduced with
+// the '--reduce' function and the worst status over all runs is kept.
+// Only the median needs all samples, the other reducers work in place.
+
+static int status_badness(int status) {
+  if (status == 10 || status == 20)
+    return 0;
+  if (status == 1)
+    return 2;
+  if (status == 2)
+    return 3;
+  return 1;
+}
+
+static void reduce_value(double *value, double sample) {
+  if (reducer == MAX_REDUCER) {
+    if (*value < sample)
+      *value = sample;
+  } else if (reducer == MIN_REDUCER) {
+    if (*value > sample)
+      *value = sample;
+  } else {
+    assert(reducer == MEAN_REDUCER);
+    *value += sample;
+  }
+}
+
+static double median(double *samples, size_t size) {
+  assert(size);
+  for (size_t i = 1; i < size; i++) {
+    double sample = samples[i];
+    size_t j = i;
+    while (j && samples[j - 1] > sample)
+      samples[j] = samples[j - 1], j--;
+    samples[j] = sample;
+  }
+  size_t middle = size / 2;
+  if (size & 1)
+    return samples[middle];
+  return (samples[middle - 1] + samples[middle]) / 2;
+}
+
+static void merge_zummaries(void) {
+  if (!size_merge_paths)
+    return;
+  double start = process_time();
+  if (!zummary_index.table)
+    index_zummaries();
+  const size_t runs = size_merge_paths + 1;
+  unsigned *counts = allocate(size_zummaries * sizeof *counts);
+  unsigned *last_runs = allocate_zeroed(size_zummaries * sizeof *last_runs);
+  double *samples = 0;
+  if (reducer == MEDIAN_REDUCER)
+    samples = allocate(3 * runs * size_zummaries * sizeof *samples);
+  for (size_t i = 0; i != size_zummaries; i++) {
+    counts[i] = 1;
+    if (samples) {
+      const struct zummary *zummary = zummaries + i;
+      double *s = samples + 3 * runs * i;
+      s[0] = zummary->time;
+      s[runs] = zummary->real;
+      s[2 * runs] = zummary->memory;
+    }
+  }
+  for (size_t run = 1; run != runs; run++) {
+    const char *path = merge_paths[run - 1];
+    struct mapping mapping;
+    memset(&mapping, 0, sizeof mapping);
+    map_file(&mapping, path);
+    init_line_reading(&mapping, path);
+    if (!read_line())
+      die("failed to read header line in '%s'", path);
+    size_t merged = 0, ignored = 0;
+    while (read_line()) {
+      struct zummary sample;
+      enum error error = parse_zummary_line(line, &sample);
+      if (error)
+        line_error(error, lineno, file_name);
+      struct zummary *zummary = find_zummary(sample.name, sample.hash);
+      if (!zummary) {
+        ignored++;
+        continue;
+      }
+      size_t i = zummary - zummaries;
+      if (last_runs[i] == run)
+        die("duplicated zummary '%s' in '%s'", sample.name, path);
+      last_runs[i] = run;
+      size_t count = counts[i]++;
+      if (status_badness(zummary->status) < status_badness(sample.status))
+        zummary->status = sample.status;
+      if (samples) {
+        double *s = samples + 3 * runs * i + count;
+        s[0] = sample.time;
+        s[runs] = sample.real;
+        s[2 * runs] = sample.memory;
+      } else {
+        reduce_value(&zummary->time, sample.time);
+        reduce_value(&zummary->real, sample.real);
+        reduce_value(&zummary->memory, sample.memory);
+      }
+      merged++;
+    }
+    unmap_file(&mapping);
+    vrb(1, "merged %zu zummaries from '%s'", merged, path);
+    if (ignored)
+      msg("ignoring %zu zummaries in '%s' of benchmarks not in first run",
+          ignored, path);
+  }
+  max_memory = 0;
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    size_t count = counts[i];
+    if (reducer == MEAN_REDUCER) {
+      zummary->time /= count;
+      zummary->real /= count;
+      zummary->memory /= count;
+    } else if (samples) {
+      double *s = samples + 3 * runs * i;
+      zummary->time = median(s, count);
+      zummary->real = median(s + runs, count);
+      zummary->memory = median(s + 2 * runs, count);
+    }
+    if (max_memory < zummary->memory)
+      max_memory = zummary->memory;
+  }
+  vrb(1, "reduced %zu runs with '%s' in %.2f seconds", runs,
+      reducer_names[reducer], process_time() - start);
+}
+
+// With '--history' every zummary read is appended to a history file once
+// (recognized by a hash of the contents of the zummary file, respectively
+// of all records parsed from 'runlim' logs).  All its records are appended
+// right after parsing, i.e., independently of the benchmarks listed.  Each
+// run in the history starts with a 'run <hash> <size>' line followed by
+// one line per benchmark with name, status, real time and memory.  From all
+// runs we compute per benchmark an exponentially weighted moving average
+// and the maximum of real time and memory as well as the number of
+// time-outs and memory-outs.  Scheduling then uses the average real time
+// but (to stay on the safe side with respect to memory limits) the maximum
+// memory.  As the history replaces the values of a zummary it can not be
+// combined with '--merge'.
+
+#define HISTORY_ALPHA 0.25
+
+static struct history *find_history(const char *name, unsigned hash) {
+  const size_t mask = history_index.mask;
+  const size_t *table = history_index.table;
+  for (size_t pos = hash & mask;; pos = (pos + 1) & mask) {
+    size_t i = table[pos];
+    if (!i)
+      return 0;
+    struct history *history = histories + i - 1;
+    if (history->hash == hash && !strcmp(history->name, name))
+      return history;
+  }
+}
+
+static void record_history(char *name, unsigned hash, int status, double real,
+                           double memory) {
+  struct history *history = find_history(name, hash);
+  if (!history) {
+    const size_t mask = history_index.mask;
+    size_t pos = hash & mask;
+    while (history_index.table[pos])
+      pos = (pos + 1) & mask;
+    history = histories + size_histories++;
+    history_index.table[pos] = size_histories;
+    memset(history, 0, sizeof *history);
+    history->name = name;
+    history->hash = hash;
+    history->real = history->max_real = real;
+    history->memory = history->max_memory = memory;
+  } else {
+    history->real += HISTORY_ALPHA * (real - history->real);
+    history->memory += HISTORY_ALPHA * (memory - history->memory);
+    if (history->max_real < real)
+      history->max_real = real;
+    if (history->max_memory < memory)
+      history->max_memory = memory;
+  }
+  history->runs++;
+  if (status == 1)
+    history->timeouts++;
+  else if (status == 2)
+    history->memouts++;
+}
+
+static uint64_t hash_zummaries(void) {
+  uint64_t res = size_zummaries;
+  for (size_t i = 0; i != size_zummaries; i++) {
+    const struct zummary *zummary = zummaries + i;
+    uint64_t words[3] = {(uint64_t)zummary->status};
+    memcpy(words + 1, &zummary->real, sizeof zummary->real);
+    memcpy(words + 2, &zummary->memory, sizeof zummary->memory);
+    res = (res ^ zummary->hash) * 0x9e3779b97f4a7c15ull;
+    for (unsigned j = 0; j != 3; j++) {
+      res = (res ^ words[j]) * 0x9e3779b97f4a7c15ull;
+      res ^= res >> 29;
+    }
+  }
+  return res;
+}
+
+static void read_history(void) {
+  if (!history_path)
+    return;
+  size_t expected;
+  if (runlim_logs) {
+    history_hash = hash_zummaries();
+    expected = size_zummaries;
+  } else {
+    history_hash = zummary_hash;
+    expected = count_lines(zummary_mapping.start, zummary_mapping.end);
+  }
+  size_t lines = 0;
+  if (file_exists(history_path)) {
+    map_file(&history_mapping, history_path);
+    lines = count_lines(history_mapping.start, history_mapping.end);
+  }
+  init_index(&history_index, lines + expected);
+  histories = allocate((lines + expected) * sizeof *histories);
+  if (!lines)
+    return;
+  init_line_reading(&history_mapping, history_path);
+  size_t runs = 0;
+  while (read_line()) {
+    if (!strncmp(line, "run ", 4)) {
+      unsigned long long run_hash;
+      size_t size;
+      if (sscanf(line + 4, "%llx %zu", &run_hash, &size) != 2)
+        die("invalid run line %zu in history '%s'", lineno, history_path);
+      if (run_hash == history_hash)
+        history_recorded = true;
+      runs++;
+      continue;
+    }
+    char *p = strchr(line, ' ');
+    int status;
+    double real, memory;
+    if (!runs || !p)
+      die("invalid line %zu in history '%s'", lineno, history_path);
+    *p++ = 0;
+    if (sscanf(p, "%d %lf %lf", &status, &real, &memory) != 3)
+      die("invalid line %zu in history '%s'", lineno, history_path);
+    record_history(line, hash_string(line), status, real, memory);
+  }
+  vrb(1, "read %zu runs of %zu benchmarks from history '%s'", runs,
+      size_histories, history_path);
+}
+
+static void append_history(void) {
+  if (!history_path)
+    return;
+  if (history_recorded) {
+    vrb(1, "zummary already recorded in history '%s'", history_path);
+    return;
+  }
+  FILE *file = fopen(history_path, "a");
+  if (!file)
+    die("could not append to history '%s'", history_path);
+  fprintf(file, "run %016llx %zu\n", (unsigned long long)history_hash,
+          size_zummaries);
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    fprintf(file, "%s %d %.2f %.1f\n", zummary->name, zummary->status,
+            zummary->real, zummary->memory);
+    record_history(zummary->name, zummary->hash, zummary->status,
+                   zummary->real, zummary->memory);
+  }
+  if (fclose(file))
+    die("could not append to history '%s'", history_path);
+  history_recorded = true;
+  vrb(1, "appended %zu zummaries to history '%s'", size_zummaries,
+      history_path);
+}
+
+static void update_history(void) {
+  if (!history_path)
+    return;
+  double start = process_time();
+  max_memory = 0;
+  size_t estimated = 0;
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    struct history *history =
+        zummary->predicted ? 0 : find_history(zummary->name, zummary->hash);
+    if (history) {
+      vrb(2,
+          "history of '%s': %u runs, %u time-outs, %u memory-outs, "
+          "real %.2f s (max %.2f s), memory %.0f MB (max %.0f MB)",
+          zummary->name, history->runs, history->timeouts, history->memouts,
+          history->real, history->max_real, history->memory,
+          history->max_memory);
+      zummary->real = history->real;
+      zummary->memory = history->max_memory;
+      estimated++;
+    }
+    if (max_memory < zummary->memory)
+      max_memory = zummary->memory;
+  }
+  vrb(1, "using history estimates for %zu zummaries in %.2f seconds",
+      estimated, process_time() - start);
+}
+
+// With '--calibrate' a (usually small) zummary of a new solver version on
+// a subset of the benchmarks is compared to the zummary read (of the old
+// version).  The geometric mean of the ratios of real time (of benchmarks
+// solved by both versions) and of memory is determined per family and
+// globally, where the family of a benchmark is the alphabetic prefix of
+// its name.  Calibrated benchmarks take the values of the new version and
+// all others are rescaled by the factors of their family, if the family
+// has enough samples, and otherwise by the global factors.  Only running
+// times of solved benchmarks are rescaled, since unsolved ones (time-outs
+// in particular) still run until they hit their limit, and solved ones
+// rescaled beyond the limit become time-outs.  Similarly memory of
+// memory-outs is kept.
+
+#define CALIBRATION_MIN_SAMPLES 3
+
+static struct family *find_family(const char *name, bool add) {
+  char key[64];
+  size_t len = 0;
+  while (len + 1 < sizeof key && isalpha((unsigned char)name[len]))
+    key[len] = name[len], len++;
+  key[len] = 0;
+  unsigned hash = hash_string(key);
+  const size_t mask = family_index.mask;
+  size_t *table = family_index.table;
+  size_t pos = hash & mask;
+  for (size_t i; (i = table[pos]); pos = (pos + 1) & mask) {
+    struct family *family = families + i - 1;
+    if (family->hash == hash && !strcmp(family->name, key))
+      return family;
+  }
+  if (!add)
+    return 0;
+  struct family *family = families + size_families++;
+  table[pos] = size_families;
+  memset(family, 0, sizeof *family);
+  family->name = allocate_string(key);
+  family->hash = hash;
+  return family;
+}
+
+static bool solved_status(int status) {
+  return status == 10 || status == 20;
+}
+
+static void rescale_real(struct zummary *zummary, double factor) {
+  if (!solved_status(zummary->status))
+    return;
+  zummary->time *= factor;
+  zummary->real *= factor;
+  bool timeout = false;
+  if (zummary->limit.time > 0 && zummary->time > zummary->limit.time)
+    zummary->time = zummary->limit.time, timeout = true;
+  if (zummary->limit.real > 0 && zummary->real > zummary->limit.real)
+    zummary->real = zummary->limit.real, timeout = true;
+  if (timeout)
+    zummary->status = 1;
+}
+
+static void add_calibration_sample(struct family *family,
+                                   const struct zummary *old,
+                                   const struct zummary *new) {
+  if (solved_status(old->status) && solved_status(new->status) &&
+      old->real > 0 && new->real > 0) {
+    family->real_sum += log(new->real / old->real);
+    family->real_samples++;
+  }
+  if (old->memory > 0 && new->memory > 0) {
+    family->memory_sum += log(new->memory / old->memory);
+    family->memory_samples++;
+  }
+}
+
+static double scaling_factor(size_t family_samples, double family_sum,
+                             size_t global_samples, double global_sum) {
+  if (family_samples >= CALIBRATION_MIN_SAMPLES)
+    return exp(family_sum / family_samples);
+  if (global_samples)
+    return exp(global_sum / global_samples);
+  return 1;
+}
+
+static void calibrate_zummaries(void) {
+  if (!calibration_path)
+    return;
+  double start = process_time();
+  if (!zummary_index.table)
+    index_zummaries();
+  struct mapping mapping;
+  memset(&mapping, 0, sizeof mapping);
+  map_file(&mapping, calibration_path);
+  size_t lines = count_lines(mapping.start, mapping.end);
+  init_index(&family_index, lines);
+  families = allocate(lines * sizeof *families);
+  bool *calibrated = allocate_zeroed(size_zummaries * sizeof *calibrated);
+  struct family global;
+  memset(&global, 0, sizeof global);
+  init_line_reading(&mapping, calibration_path);
+  if (!read_line())
+    die("failed to read header line in '%s'", calibration_path);
+  size_t size_calibrated = 0, ignored = 0;
+  while (read_line()) {
+    struct zummary sample;
+    enum error error = parse_zummary_line(line, &sample);
+    if (error)
+      line_error(error, lineno, file_name);
+    struct zummary *zummary = find_zummary(sample.name, sample.hash);
+    if (!zummary) {
+      ignored++;
+      continue;
+    }
+    size_t i = zummary - zummaries;
+    if (calibrated[i])
+      die("duplicated zummary '%s' in '%s'", sample.name, calibration_path);
+    calibrated[i] = true;
+    size_calibrated++;
+    if (!zummary->predicted) {
+      add_calibration_sample(find_family(zummary->name, true), zummary,
+                             &sample);
+      add_calibration_sample(&global, zummary, &sample);
+    }
+    zummary->status = sample.status;
+    zummary->time = sample.time;
+    zummary->real = sample.real;
+    zummary->memory = sample.memory;
+    zummary->limit = sample.limit;
+    zummary->predicted = false;
+  }
+  unmap_file(&mapping);
+  if (ignored)
+    msg("ignoring %zu zummaries in '%s' without benchmark", ignored,
+        calibration_path);
+  for (size_t i = 0; i != size_families; i++) {
+    const struct family *family = families + i;
+    vrb(2, "family '%s' real factor %.3f (%zu samples) memory factor %.3f "
+        "(%zu samples)", family->name,
+        scaling_factor(0, 0, family->real_samples, family->real_sum),
+        family->real_samples,
+        scaling_factor(0, 0, family->memory_samples, family->memory_sum),
+        family->memory_samples);
+  }
+  max_memory = 0;
+  for (size_t i = 0; i != size_zummaries; i++) {
+    struct zummary *zummary = zummaries + i;
+    if (!calibrated[i]) {
+      const struct family *family = find_family(zummary->name, false);
+      struct family none;
+      if (!family) {
+        memset(&none, 0, sizeof none);
+        family = &none;
+      }
+      double real_factor =
+          scaling_factor(family->real_samples, family->real_sum,
+                         global.real_samples, global.real_sum);
+      double memory_factor =
+          scaling_factor(family->memory_samples, family->memory_sum,
+                         global.memory_samples, global.memory_sum);
+      rescale_real(zummary, real_factor);
+      if (zummary->status != 2)
+        zummary->memory *= memory_factor;
+    }
+    if (max_memory < zummary->memory)
+      max_memory = zummary->memory;
+  }
+  msg("calibrated %zu zummaries with global real factor %.3f and memory "
+      "factor %.3f",
+      size_calibrated,
+      scaling_factor(0, 0, global.real_samples, global.real_sum),
+      scaling_factor(0, 0, global.memory_samples, global.memory_sum));
+  vrb(1, "rescaled %zu zummaries with %zu families in %.2f seconds",
+      size_zummaries - size_calibrated, size_families,
+      process_time() - start);
+}
+
+// Running times measured on one machine are normalized with '--speed' to
+// the machine we plan for.  The speed factor is either given directly
+// (larger than one if the planned machine is faster) or fitted as the
+// geometric mean of the ratios of real time in the zummary read and in a
+// zummary of the same solver on the planned machine, over the benchmarks
+// solved in both.  As with calibration only solved benchmarks are rescaled
+// and become time-outs if a slower machine pushes them beyond the limit.
+
+static double fit_machine_speed(void) {
+  if (!zummary_index.table)
+    index_zummaries();
+  struct mapping mapping;
+  memset(&mapping, 0, sizeof mapping);
+  map_file(&mapping, speed_path);
+  init_line_reading(&mapping, speed_path);
+  if (!read_line())
+    die("failed to read header line in '%s'", speed_path);
+  size_t samples = 0;
+  double sum = 0;
+  while (read_line()) {
+    struct zummary sample;
+    enum error error = parse_zummary_line(line, &sample);
+    if (error)
+      line_error(error, lineno, file_name);
+    struct zummary *zummary = find_zummary(sample.name, sample.hash);
+    if (!zummary || zummary->predicted || !solved_status(zummary->status) ||
+        !solved_status(sample.status) || zummary->real <= 0 ||
+        sample.real <= 0)
+      continue;
+    sum += log(zummary->real / sample.real);
+    samples++;
+  }
+  unmap_file(&mapping);
+  if (!samples)
+    die("no benchmark solved in both zummary and '%s' to fit speed",
+        speed_path);
+  double res = exp(sum / samples);
+  vrb(1, "fitted machine speed factor %.3f from %zu benchmarks in '%s'", res,
+      samples, speed_path);
+  return res;
+}
+
+static void normalize_machine_speed(void) {
+  if (speed_path)
+    machine_speed = fit_machine_speed();
+  if (!machine_speed || machine_speed == 1)
+    return;
+  for (size_t i = 0; i != size_zummaries; i++)
+    rescale_real(zummaries + i, 1 / machine_speed);
+  msg("normalized running times by machine speed factor %.3f",
+      machine_speed);
+}
+
+// The node simulation assumes by default identical nodes.  With one or more
+// '--node-type <nodes>:<speed>' options the nodes of each type run buckets
+// with the given relative speed.  Faster nodes come first such that idle
+// nodes are filled with the fastest ones.  Again only solved benchmarks
+// run faster or slower (up to the limit) while a bucket with an unsolved
+// benchmark runs at least until that one hits its limit on any node.
+
+static double bucket_real_on_node(const struct bucket *bucket, double speed) {
+  double res = 0;
+  for (size_t i = 0; i != bucket->size; i++) {
+    unsigned idx = bucket->zummaries[i];
+    double real = hot.real[idx];
+    if (get_bit(hot.solved, idx)) {
+      real /= speed;
+      double limit = zummaries[idx].limit.real;
+      if (limit > 0 && real > limit)
+        real = limit;
+    }
+    if (res < real)
+      res = real;
+  }
+  return res;
 }
 
-static void parse_benchmark3(struct benchmark *benchmark) {
-  char *p = line;
-  size_t number = 0;
-  if (!isdigit(*p))
-  EXPECTED_DIGIT:
-    die("expected digit in line %zu in '%s'", lineno, file_name);
-  char ch;
-  while ((ch = *p++) != ' ')
-    if (!isdigit(ch))
-      goto EXPECTED_DIGIT;
-    else
-      number = 10 * number + (ch - '0');
-  benchmark->number = number;
-  for (size_t i = 0; i != size_benchmarks; i++)
-    if (benchmarks[i].number == number)
-      die("benchmark number %zu at line %zu in '%s' "
-          "already used at line %zu",
-          number, size_benchmarks + 1, file_name, i + 1);
-  char *q = p;
-  while ((ch = *p) != ' ')
-    if (!ch)
-      die("line %zu truncated in '%s'", lineno, file_name);
-    else
-      p++;
-  *p++ = 0;
-  if (!(benchmark->path = strdup(q)))
-    out_of_memory("copying benchmark path in");
-  if (!(benchmark->name = strdup(p)))
-    out_of_memory("copying benchmark name");
+static void init_node_speeds(void) {
+  for (size_t i = 1; i < size_node_types; i++) {
+    struct node_type node_type = node_types[i];
+    size_t j = i;
+    while (j && node_types[j - 1].speed < node_type.speed)
+      node_types[j] = node_types[j - 1], j--;
+    node_types[j] = node_type;
+  }
+  node_speeds = allocate(size_nodes * sizeof *node_speeds);
+  for (size_t i = 0, j = 0; i != size_node_types; i++) {
+    const struct node_type *node_type = node_types + i;
+    vrb(1, "assuming %zu nodes with speed %.3f", node_type->nodes,
+        node_type->speed);
+    for (size_t k = 0; k != node_type->nodes; k++)
+      node_speeds[j++] = node_type->speed;
+  }
 }
 
-static void parse_benchmark(struct benchmark *benchmark) {
-  if (!entries_per_benchmark_line)
-    determine_entries_per_benchmark_line();
-  if (entries_per_benchmark_line == 2)
-    parse_benchmark2(benchmark);
+// With '--select <benchmarks>' only a small representative subset of the
+// benchmarks is scheduled (and printed with '-g'), e.g., to run it first
+// on new hardware or with a new solver version for '--calibrate'.  The
+// zummaries are stratified by status class (solved, time-out, memory-out
+// or other), the binary logarithm of real time and that of memory.  Each
+// stratum gets a share of the subset proportional to its size but at least
+// one benchmark (largest remainder method) and within a stratum benchmarks
+// are picked evenly spread over their real time.  The subset size is
+// rounded up to fill the last bucket, since its cores are allocated anyway,
+// and raised (again to full buckets) if there are more strata than that.
+
+static uint64_t stratum_key(const struct zummary *zummary) {
+  uint64_t status_class;
+  if (solved_status(zummary->status))
+    status_class = 0;
+  else if (zummary->status == 1)
+    status_class = 1;
+  else if (zummary->status == 2)
+    status_class = 2;
   else
-    parse_benchmark3(benchmark);
+    status_class = 3;
+  uint64_t real_bin = zummary->real > 1 ? (uint64_t)log2(zummary->real) : 0;
+  uint64_t memory_bin =
+      zummary->memory > 1 ? (uint64_t)log2(zummary->memory) : 0;
+  return status_class << 32 | (real_bin & 0xffff) << 16 | (memory_bin & 0xffff);
 }
 
-static void push_benchmark(struct benchmark *benchmark) {
-  if (size_benchmarks == capacity_benchmarks) {
-    capacity_benchmarks = capacity_benchmarks ? 2 * capacity_benchmarks : 1;
-    benchmarks = realloc(benchmarks, capacity_benchmarks * sizeof *benchmarks);
-    if (!benchmarks)
-      out_of_memory("reallocating benchmarks");
+static int compare_stratified(const void *p, const void *q) {
+  const struct stratified *a = p, *b = q;
+  if (a->key != b->key)
+    return a->key < b->key ? -1 : 1;
+  if (a->real != b->real)
+    return a->real < b->real ? -1 : 1;
+  return a->index < b->index ? -1 : a->index > b->index;
+}
+
+static void select_subset(void) {
+  if (!size_selection)
+    return;
+  size_t size = bucket_size ? bucket_size : BUCKET_SIZE;
+  size_t target = (size_selection + size - 1) / size * size;
+  if (target >= size_zummaries) {
+    msg("selecting all %zu benchmarks", size_zummaries);
+    return;
   }
-  benchmarks[size_benchmarks++] = *benchmark;
+  struct stratified *stratified =
+      allocate(size_zummaries * sizeof *stratified);
+  for (size_t i = 0; i != size_zummaries; i++) {
+    stratified[i].key = stratum_key(zummaries + i);
+    stratified[i].real = zummaries[i].real;
+    stratified[i].index = i;
+  }
+  qsort(stratified, size_zummaries, sizeof *stratified, compare_stratified);
+  struct stratum *strata = allocate(size_zummaries * sizeof *strata);
+  size_t size_strata = 0, allocated = 0;
+  for (size_t i = 0, j; i != size_zummaries; i = j) {
+    for (j = i + 1;
+         j != size_zummaries && stratified[j].key == stratified[i].key; j++)
+      ;
+    struct stratum *stratum = strata + size_strata++;
+    stratum->start = i;
+    stratum->size = j - i;
+  }
+  if (size_strata > target) {
+    size_t raised = (size_strata + size - 1) / size * size;
+    if (raised >= size_zummaries) {
+      msg("selecting all %zu benchmarks to cover all %zu strata",
+          size_zummaries, size_strata);
+      return;
+    }
+    msg("raising selection from %zu to %zu benchmarks to cover all %zu strata",
+        target, raised, size_strata);
+    target = raised;
+  }
+  for (size_t i = 0; i != size_strata; i++) {
+    struct stratum *stratum = strata + i;
+    stratum->quota = (double)target * stratum->size / size_zummaries;
+    stratum->selected = stratum->quota < 1 ? 1 : stratum->quota;
+    allocated += stratum->selected;
+  }
+  while (allocated > target) {
+    struct stratum *most = 0;
+    for (size_t i = 0; i != size_strata; i++) {
+      struct stratum *stratum = strata + i;
+      if (stratum->selected > 1 &&
+          (!most || stratum->selected - stratum->quota >
+                        most->selected - most->quota))
+        most = stratum;
+    }
+    most->selected--, allocated--;
+  }
+  while (allocated < target) {
+    struct stratum *least = 0;
+    for (size_t i = 0; i != size_strata; i++) {
+      struct stratum *stratum = strata + i;
+      if (stratum->selected < stratum->size &&
+          (!least || stratum->quota - stratum->selected >
+                         least->quota - least->selected))
+        least = stratum;
+    }
+    least->selected++, allocated++;
+  }
+  bool *selected = allocate_zeroed(size_zummaries * sizeof *selected);
+  for (size_t i = 0; i != size_strata; i++) {
+    const struct stratum *stratum = strata + i;
+    for (size_t j = 0; j != stratum->selected; j++) {
+      size_t pos = (2 * j + 1) * stratum->size / (2 * stratum->selected);
+      selected[stratified[stratum->start + pos].index] = true;
+    }
+  }
+  unsigned *map = allocate(size_zummaries * sizeof *map);
+  struct zummary *subset_zummaries = allocate(target * sizeof *zummaries);
+  struct benchmark *subset_benchmarks = allocate(target * sizeof *benchmarks);
+  size_t size_subset = 0;
+  max_memory = 0;
+  for (size_t i = 0; i != size_zummaries; i++)
+    if (selected[i]) {
+      map[i] = size_subset;
+      subset_zummaries[size_subset++] = zummaries[i];
+      if (max_memory < zummaries[i].memory)
+        max_memory = zummaries[i].memory;
+    }
+  assert(size_subset == target);
+  size_subset = 0;
+  for (size_t i = 0; i != size_benchmarks; i++) {
+    struct benchmark *benchmark = benchmarks + i;
+    size_t idx = benchmark->zummary - zummaries;
+    if (!selected[idx])
+      continue;
+    struct benchmark *b = subset_benchmarks + size_subset++;
+    struct zummary *z = subset_zummaries + map[idx];
+    *b = *benchmark;
+    b->zummary = z;
+    z->benchmark = b;
+  }
+  assert(size_subset == target);
+  msg("selected %zu of %zu benchmarks from %zu strata", target,
+      size_zummaries, size_strata);
+  zummaries = subset_zummaries;
+  benchmarks = subset_benchmarks;
+  size_zummaries = capacity_zummaries = target;
+  size_benchmarks = capacity_benchmarks = target;
 }
 
-static void parse_zummary(struct zummary *zummary) {
-  char *p = line, ch;
-  while ((ch = *p) != ' ')
-    if (!ch)
-      die("line %zu truncated in '%s'", lineno, file_name);
-    else
-      p++;
-  *p++ = 0;
-  if (!(zummary->name = strdup(line)))
-    out_of_memory("allocating zummary name");
-  if (sscanf(p, "%d %lf %lf %lf %lf %lf %lf", &zummary->status, &zummary->time,
-             &zummary->real, &zummary->memory, &zummary->limit.time,
-             &zummary->limit.real, &zummary->limit.memory) != 7)
-    die("invalid zummary line %zu in '%s'", lineno, file_name);
-  if (max_memory < zummary->memory)
-    max_memory = zummary->memory;
+// The node simulation dispatches buckets in order to the node which
+// becomes idle first, where ties are broken by the node position.  As long
+// as there are nodes which never ran a bucket the first of them is used.
+// Nodes which already ran a bucket are kept in a binary min-heap ordered by
+// end time and position, which makes the simulation take time logarithmic
+// in the number of nodes per bucket.
+
+static size_t *node_heap;
+
+static bool node_ends_before(size_t a, size_t b) {
+  double end_a = nodes[a]->end, end_b = nodes[b]->end;
+  return end_a < end_b || (end_a == end_b && a < b);
 }
 
-static void push_zummary(struct zummary *zummary) {
-  if (size_zummaries == capacity_zummaries) {
-    capacity_zummaries = capacity_zummaries ? 2 * capacity_zummaries : 1;
-    zummaries = realloc(zummaries, capacity_zummaries * sizeof *zummaries);
-    if (!zummaries)
-      out_of_memory("reallocating zummaries");
+static void push_node(size_t size_heap, size_t pos) {
+  size_t i = size_heap;
+  while (i) {
+    size_t parent = (i - 1) / 2;
+    if (!node_ends_before(pos, node_heap[parent]))
+      break;
+    node_heap[i] = node_heap[parent];
+    i = parent;
   }
-  zummaries[size_zummaries++] = *zummary;
+  node_heap[i] = pos;
 }
 
-static void sort_zummaries_by_memory(void) {
-  assert(size_zummaries);
-  for (size_t i = 0; i != size_zummaries - 1; i++) {
-    if (zummaries[i].scheduled)
-      continue;
-    for (size_t j = i + 1; j != size_zummaries; j++) {
-      if (zummaries[j].scheduled)
-        continue;
-      if (zummaries[i].memory < zummaries[j].memory)
-        continue;
-      if (zummaries[i].memory == zummaries[j].memory &&
-          zummaries[i].real <= zummaries[j].real)
-        continue;
-      struct zummary tmp = zummaries[i];
-      zummaries[i] = zummaries[j];
-      zummaries[j] = tmp;
-    }
+static void sift_down_node(size_t size_heap) {
+  size_t pos = node_heap[0], i = 0;
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= size_heap)
+      break;
+    if (child + 1 < size_heap &&
+        node_ends_before(node_heap[child + 1], node_heap[child]))
+      child++;
+    if (!node_ends_before(node_heap[child], pos))
+      break;
+    node_heap[i] = node_heap[child];
+    i = child;
   }
+  node_heap[i] = pos;
 }
 
-static void sort_zummaries_by_time(void) {
-  assert(size_zummaries);
-  for (size_t i = 0; i != size_zummaries - 1; i++) {
-    if (zummaries[i].scheduled)
-      continue;
-    for (size_t j = i + 1; j != size_zummaries; j++) {
-      if (zummaries[j].scheduled)
-        continue;
-      if (zummaries[i].real < zummaries[j].real)
-        continue;
-      if (zummaries[i].real == zummaries[j].real &&
-          zummaries[i].memory <= zummaries[j].memory)
-        continue;
-      struct zummary tmp = zummaries[i];
-      zummaries[i] = zummaries[j];
-      zummaries[j] = tmp;
+static double simulate_nodes(void) {
+  nodes = allocate_zeroed(size_nodes * sizeof *nodes);
+  node_heap = allocate(size_nodes * sizeof *node_heap);
+  size_t size_heap = 0;
+  double latency = 0;
+  for (size_t i = 0; i != tasks; i++) {
+    struct bucket *next = buckets + i;
+    struct bucket *replace = 0;
+    size_t pos;
+    if (size_heap < size_nodes)
+      pos = size_heap;
+    else {
+      pos = node_heap[0];
+      replace = nodes[pos];
     }
+    double start = replace ? replace->end : 0;
+    double real = next->real;
+    if (node_speeds && node_speeds[pos] != 1)
+      real = bucket_real_on_node(next, node_speeds[pos]);
+    double end = start + real;
+    next->start = start;
+    next->end = end;
+    vrb(1, "running bucket[%zu] at node %zu after %.0f s (%.0f-%.0f)", i + 1,
+        pos, next->start, next->start, next->end);
+    nodes[pos] = next;
+    if (replace)
+      sift_down_node(size_heap);
+    else
+      push_node(size_heap++, pos);
+    if (end > latency)
+      latency = end;
   }
+  return latency;
 }
 
-static void sort_buckets_by_real(void) {
-  assert(tasks);
-  for (size_t i = 0; i != tasks; i++)
-    for (size_t j = i + 1; j != tasks; j++) {
-      if (buckets[i].real <= buckets[j].real)
-        continue;
-      struct bucket tmp = buckets[i];
-      buckets[i] = buckets[j];
-      buckets[j] = tmp;
-    }
+// With '--cache' the parsed and matched benchmarks and zummaries are saved
+// in a binary cache file next to the zummary file.  The cache is only used
+// if size, modification time and a hash of the contents of both input
+// files match those recorded in the cache.  It is mapped to memory and
+// names then point into the string pool of the mapped cache file.
+
+#define CACHE_MAGIC "ZORTCACH"
+#define CACHE_VERSION 3
+
+static uint64_t hash_mapping(const struct mapping *mapping) {
+  const char *p = mapping->start, *end = mapping->end;
+  uint64_t res = end - p;
+  while (end - p >= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof word);
+    res = (res ^ word) * 0x9e3779b97f4a7c15ull;
+    res ^= res >> 29;
+    p += 8;
+  }
+  while (p != end)
+    res = (res ^ (unsigned char)*p++) * 0x9e3779b97f4a7c15ull;
+  return res;
 }
 
-static void schedule_zummary(struct bucket *bucket, struct zummary *zummary) {
-  assert(!zummary->scheduled);
-  assert(bucket->size < bucket_size);
-  bucket->zummaries[bucket->size++] = zummary;
-  if (bucket->real < zummary->real)
-    bucket->real = zummary->real;
-  bucket->memory += zummary->memory;
-  if (zummary->status == 2 || zummary->memory >= zummary->limit.memory) {
-    zummary->memory_limit_hit = true;
-    bucket->memory_limit_hit++;
-    if (max_memory_limit_hit < bucket->memory_limit_hit)
-      max_memory_limit_hit = bucket->memory_limit_hit;
-  } else
-    zummary->memory_limit_hit = false;
-  zummary->scheduled = true;
-  scheduled++;
+static void init_cached_file(struct cached_file *file,
+                             const struct mapping *mapping, uint64_t hash) {
+  file->size = mapping->end - mapping->start;
+  file->mtime = mapping->mtime;
+  file->hash = hash;
 }
 
-static size_t next_bucket(size_t j) {
-  assert(j < tasks);
-  size_t res = j;
-  for (;;) {
-    if (++res == tasks)
-      res = 0;
-    size_t max_size = (res + 1 == tasks) ? last_bucket_size : bucket_size;
-    if (buckets[res].size < max_size)
-      return res;
+static bool match_cached_file(const struct cached_file *file,
+                              const struct mapping *mapping, uint64_t hash) {
+  struct cached_file expected;
+  init_cached_file(&expected, mapping, hash);
+  return file->size == expected.size && file->mtime == expected.mtime &&
+         file->hash == expected.hash;
+}
+
+static bool load_cache(void) {
+  size_t cache_path_len = strlen(zummary_path) + strlen(".cache") + 1;
+  cache_path = allocate(cache_path_len);
+  snprintf(cache_path, cache_path_len, "%s.cache", zummary_path);
+  benchmarks_hash = hash_mapping(&benchmarks_mapping);
+  if (!history_path)
+    zummary_hash = hash_mapping(&zummary_mapping);
+  else if (!history_recorded) {
+    vrb(1, "not loading cache '%s' to record zummary in history", cache_path);
+    return false;
+  }
+  if (!file_exists(cache_path)) {
+    vrb(1, "cache '%s' does not exist yet", cache_path);
+    return false;
+  }
+  int fd = open(cache_path, O_RDONLY);
+  if (fd < 0) {
+    vrb(1, "could not open cache '%s'", cache_path);
+    return false;
   }
+  struct stat buf;
+  if (fstat(fd, &buf) || (size_t)buf.st_size < sizeof(struct cache_header)) {
+    close(fd);
+    vrb(1, "ignoring invalid cache '%s'", cache_path);
+    return false;
+  }
+  size_t size = buf.st_size;
+  void *start = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (start == MAP_FAILED) {
+    vrb(1, "could not map cache '%s' to memory", cache_path);
+    return false;
+  }
+  cache_mapping.start = start;
+  cache_mapping.end = cache_mapping.start + size;
+  const struct cache_header *header = start;
+  const struct cached_benchmark *cached_benchmarks = (void *)(header + 1);
+  const struct cached_zummary *cached_zummaries =
+      (void *)(cached_benchmarks + header->size_benchmarks);
+  const char *strings = (void *)(cached_zummaries + header->size_zummaries);
+  if (memcmp(header->magic, CACHE_MAGIC, sizeof header->magic) ||
+      header->version != CACHE_VERSION || header->subset != subset ||
+      header->predict != predict ||
+      header->size_benchmarks > UINT_MAX || header->size_zummaries > UINT_MAX ||
+      header->size_benchmarks != header->size_zummaries ||
+      sizeof *header + header->size_benchmarks * sizeof *cached_benchmarks +
+              header->size_zummaries * sizeof *cached_zummaries +
+              header->size_strings !=
+          size ||
+      (header->size_strings && strings[header->size_strings - 1])) {
+    vrb(1, "ignoring invalid cache '%s'", cache_path);
+  UNMAP_AND_IGNORE_CACHE:
+    unmap_file(&cache_mapping);
+    cache_mapping.start = cache_mapping.end = 0;
+    return false;
+  }
+  if (!match_cached_file(&header->benchmarks, &benchmarks_mapping,
+                         benchmarks_hash) ||
+      !match_cached_file(&header->zummary, &zummary_mapping, zummary_hash)) {
+    vrb(1, "ignoring outdated cache '%s'", cache_path);
+    goto UNMAP_AND_IGNORE_CACHE;
+  }
+  size_t size_cached = header->size_benchmarks;
+  for (size_t i = 0; i != size_cached; i++) {
+    const struct cached_benchmark *b = cached_benchmarks + i;
+    const struct cached_zummary *z = cached_zummaries + i;
+    if ((b->path != UINT64_MAX && b->path >= header->size_strings) ||
+        b->name >= header->size_strings || b->zummary >= size_cached ||
+        z->name >= header->size_strings || z->benchmark >= size_cached) {
+      vrb(1, "ignoring corrupted cache '%s'", cache_path);
+      goto UNMAP_AND_IGNORE_CACHE;
+    }
+  }
+  benchmarks = allocate(size_cached * sizeof *benchmarks);
+  zummaries = allocate(size_cached * sizeof *zummaries);
+  for (size_t i = 0; i != size_cached; i++) {
+    const struct cached_benchmark *c = cached_benchmarks + i;
+    struct benchmark *benchmark = benchmarks + i;
+    benchmark->number = c->number;
+    benchmark->path = c->path == UINT64_MAX ? 0 : (char *)strings + c->path;
+    benchmark->name = (char *)strings + c->name;
+    benchmark->hash = c->hash;
+    benchmark->zummary = zummaries + c->zummary;
+  }
+  for (size_t i = 0; i != size_cached; i++) {
+    const struct cached_zummary *c = cached_zummaries + i;
+    struct zummary *zummary = zummaries + i;
+    zummary->name = (char *)strings + c->name;
+    zummary->hash = c->hash;
+    zummary->status = c->status;
+    zummary->time = c->time;
+    zummary->real = c->real;
+    zummary->memory = c->memory;
+    zummary->limit.time = c->limit_time;
+    zummary->limit.real = c->limit_real;
+    zummary->limit.memory = c->limit_memory;
+    zummary->predicted = c->predicted;
+    zummary->benchmark = benchmarks + c->benchmark;
+  }
+  size_benchmarks = capacity_benchmarks = size_cached;
+  size_zummaries = capacity_zummaries = size_cached;
+  max_memory = header->max_memory;
+  vrb(1, "loaded %zu benchmarks and zummaries from cache '%s'", size_cached,
+      cache_path);
+  return true;
 }
 
-static const char *simplify_directory_path(const char *directory_path) {
-  size_t len = strlen(directory_path);
-  if (!len || directory_path[len - 1] != '/')
-    return directory_path;
-  simplified_directory_path = malloc(len + 1);
-  if (!simplified_directory_path)
-    out_of_memory("allocating simplified directory path");
-  strcpy(simplified_directory_path, directory_path);
-  char *p = simplified_directory_path + len - 1;
-  while (p != simplified_directory_path && *p == '/')
-    p--;
-  p[1] = 0;
-  return simplified_directory_path;
+static uint64_t cache_string(uint64_t *offset, const char *str) {
+  uint64_t res = *offset;
+  *offset += strlen(str) + 1;
+  return res;
+}
+
+static void write_cache(void) {
+  size_t tmp_path_len = strlen(cache_path) + strlen(".tmp") + 1;
+  char *tmp_path = allocate(tmp_path_len);
+  snprintf(tmp_path, tmp_path_len, "%s.tmp", cache_path);
+  FILE *file = fopen(tmp_path, "w");
+  if (!file) {
+    msg("could not write cache '%s'", tmp_path);
+    return;
+  }
+  struct cache_header header;
+  memset(&header, 0, sizeof header);
+  memcpy(header.magic, CACHE_MAGIC, sizeof header.magic);
+  header.version = CACHE_VERSION;
+  init_cached_file(&header.benchmarks, &benchmarks_mapping, benchmarks_hash);
+  init_cached_file(&header.zummary, &zummary_mapping, zummary_hash);
+  header.size_benchmarks = size_benchmarks;
+  header.size_zummaries = size_zummaries;
+  uint64_t offset = 0;
+  for (size_t i = 0; i != size_benchmarks; i++) {
+    if (benchmarks[i].path)
+      (void)cache_string(&offset, benchmarks[i].path);
+    (void)cache_string(&offset, benchmarks[i].name);
+  }
+  for (size_t i = 0; i != size_zummaries; i++)
+    (void)cache_string(&offset, zummaries[i].name);
+  header.size_strings = offset;
+  header.subset = subset;
+  header.predict = predict;
+  header.max_memory = max_memory;
+  bool written = fwrite(&header, sizeof header, 1, file) == 1;
+  offset = 0;
+  for (size_t i = 0; written && i != size_benchmarks; i++) {
+    const struct benchmark *benchmark = benchmarks + i;
+    struct cached_benchmark c;
+    memset(&c, 0, sizeof c);
+    c.number = benchmark->number;
+    c.path = benchmark->path ? cache_string(&offset, benchmark->path)
+                             : UINT64_MAX;
+    c.name = cache_string(&offset, benchmark->name);
+    c.hash = benchmark->hash;
+    c.zummary = benchmark->zummary - zummaries;
+    written = fwrite(&c, sizeof c, 1, file) == 1;
+  }
+  for (size_t i = 0; written && i != size_zummaries; i++) {
+    const struct zummary *zummary = zummaries + i;
+    struct cached_zummary c;
+    memset(&c, 0, sizeof c);
+    c.name = cache_string(&offset, zummary->name);
+    c.hash = zummary->hash;
+    c.benchmark = zummary->benchmark - benchmarks;
+    c.status = zummary->status;
+    c.predicted = zummary->predicted;
+    c.time = zummary->time;
+    c.real = zummary->real;
+    c.memory = zummary->memory;
+    c.limit_time = zummary->limit.time;
+    c.limit_real = zummary->limit.real;
+    c.limit_memory = zummary->limit.memory;
+    written = fwrite(&c, sizeof c, 1, file) == 1;
+  }
+  for (size_t i = 0; written && i != size_benchmarks; i++) {
+    if (benchmarks[i].path)
+      written = fputs(benchmarks[i].path, file) != EOF && fputc(0, file) != EOF;
+    if (written)
+      written = fputs(benchmarks[i].name, file) != EOF && fputc(0, file) != EOF;
+  }
+  for (size_t i = 0; written && i != size_zummaries; i++)
+    written = fputs(zummaries[i].name, file) != EOF && fputc(0, file) != EOF;
+  if (fclose(file))
+    written = false;
+  if (written && !rename(tmp_path, cache_path))
+    vrb(1, "wrote cache '%s'", cache_path);
+  else {
+    msg("could not write cache '%s'", cache_path);
+    unlink(tmp_path);
+  }
 }
 
 static double average(double a, double b) { return b ? a / b : a; }
@@ -562,6 +3863,13 @@ int main(int argc, char **argv) {
       INVALID_ARGUMENT:
         die("invalid argument in '%s %s'", arg, argv[i]);
       bucket_size = tmp;
+    } else if (!strcmp(arg, "-j")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      int tmp = atoi(argv[i]);
+      if (tmp <= 0)
+        goto INVALID_ARGUMENT;
+      threads = tmp;
     } else if (!strcmp(arg, "-f")) {
       if (++i == argc)
         goto ARGUMENT_MISSING;
@@ -604,11 +3912,98 @@ int main(int argc, char **argv) {
       if (tmp < 0)
         goto INVALID_ARGUMENT;
       cents_per_kwh = tmp;
+    } else if (!strcmp(arg, "--cache"))
+      use_cache = true;
+    else if (!strcmp(arg, "--runlim"))
+      runlim_logs = true;
+    else if (!strcmp(arg, "--subset"))
+      subset = true;
+    else if (!strcmp(arg, "--predict"))
+      predict = true;
+    else if (!strcmp(arg, "--calibrate")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      if (calibration_path)
+        die("two calibration paths '--calibrate %s' and '--calibrate %s'",
+            calibration_path, argv[i]);
+      calibration_path = argv[i];
+    } else if (!strcmp(arg, "--history")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      if (history_path)
+        die("two history paths '--history %s' and '--history %s'",
+            history_path, argv[i]);
+      history_path = argv[i];
+    } else if (!strcmp(arg, "--merge")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      if (!merge_paths && !(merge_paths = malloc(argc * sizeof *merge_paths)))
+        out_of_memory("allocating merge paths");
+      merge_paths[size_merge_paths++] = argv[i];
+    } else if (!strcmp(arg, "--reduce")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      size_t size_reducers = sizeof reducer_names / sizeof *reducer_names;
+      size_t j = 0;
+      while (j != size_reducers && strcmp(argv[i], reducer_names[j]))
+        j++;
+      if (j == size_reducers)
+        goto INVALID_ARGUMENT;
+      reducer = j;
+    } else if (!strcmp(arg, "--speed")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      if (machine_speed || speed_path)
+        die("multiple '--speed' options");
+      char *end;
+      double tmp = strtod(argv[i], &end);
+      if (end != argv[i] && !*end) {
+        if (tmp <= 0)
+          goto INVALID_ARGUMENT;
+        machine_speed = tmp;
+      } else
+        speed_path = argv[i];
+    } else if (!strcmp(arg, "--node-type")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      struct node_type node_type;
+      int consumed = 0;
+      if (sscanf(argv[i], "%zu:%lf%n", &node_type.nodes, &node_type.speed,
+                 &consumed) != 2 ||
+          argv[i][consumed] || !node_type.nodes || node_type.speed <= 0)
+        goto INVALID_ARGUMENT;
+      if (!node_types && !(node_types = malloc(argc * sizeof *node_types)))
+        out_of_memory("allocating node types");
+      node_types[size_node_types++] = node_type;
+    } else if (!strcmp(arg, "--select")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      int tmp = atoi(argv[i]);
+      if (tmp <= 0)
+        goto INVALID_ARGUMENT;
+      size_selection = tmp;
+    } else if (!strcmp(arg, "--pack"))
+      pack = true;
+    else if (!strcmp(arg, "--improve")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      char *end;
+      double tmp = strtod(argv[i], &end);
+      if (end == argv[i] || *end || tmp <= 0)
+        goto INVALID_ARGUMENT;
+      improve_budget = tmp;
     } else if (!strcmp(arg, "--euro"))
       use_euro_sign = true;
     else if (!strcmp(arg, "--dollar"))
       use_euro_sign = false;
-    else if (arg[0] == '-')
+    else if (!strcmp(arg, "--zummary")) {
+      if (++i == argc)
+        goto ARGUMENT_MISSING;
+      if (zummary_path)
+        die("two zummary paths '--zummary %s' and '--zummary %s'",
+            zummary_path, argv[i]);
+      zummary_path = argv[i];
+    } else if (arg[0] == '-' && arg[1])
       die("invalid option '%s' (try '-h')", arg);
     else if (!benchmarks_path)
       benchmarks_path = arg;
@@ -618,52 +4013,107 @@ int main(int argc, char **argv) {
       die("too many arguments '%s', '%s' and '%s' (try '-h')", benchmarks_path,
           directory_path, arg);
   }
-  if (!benchmarks_path) {
-    assert(!directory_path);
-    die("benchmark and directory path missing (try '-h')");
+  benchmarks_path = normalize_stdin_path(benchmarks_path);
+  directory_path = normalize_stdin_path(directory_path);
+  zummary_path = normalize_stdin_path(zummary_path);
+  if (zummary_path) {
+    if (directory_path)
+      die("too many arguments '%s' and '%s' with '--zummary' (try '-h')",
+          benchmarks_path, directory_path);
+    if (benchmarks_path && benchmarks_path != stdin_path &&
+        directory_exists(benchmarks_path)) {
+      directory_path = simplify_directory_path(benchmarks_path);
+      missing_benchmarks_path = find_file(directory_path, "benchmarks");
+      benchmarks_path = missing_benchmarks_path;
+    } else if (!benchmarks_path) {
+      if (zummary_path == stdin_path)
+        die("benchmarks path missing (try '-h')");
+      directory_path = directory_of(zummary_path);
+      missing_benchmarks_path = find_file(directory_path, "benchmarks");
+      benchmarks_path = missing_benchmarks_path;
+    }
+  } else {
+    if (!benchmarks_path) {
+      assert(!directory_path);
+      die("benchmark and directory path missing (try '-h')");
+    }
+    if (directory_path == stdin_path) {
+      directory_path = benchmarks_path;
+      benchmarks_path = stdin_path;
+    }
+    if (directory_path)
+      directory_path = simplify_directory_path(directory_path);
+    else if (benchmarks_path == stdin_path)
+      die("directory path missing (try '-h')");
+    else {
+      directory_path = simplify_directory_path(benchmarks_path);
+      if (!directory_exists(directory_path))
+      DIRECTORY_DOES_NOT_EXISTS:
+        die("directory '%s' does not exist", directory_path);
+      missing_benchmarks_path = find_file(directory_path, "benchmarks");
+      benchmarks_path = missing_benchmarks_path;
+    }
+    if (benchmarks_path != stdin_path && directory_exists(benchmarks_path) &&
+        file_exists(directory_path)) {
+      const char *tmp = benchmarks_path;
+      benchmarks_path = directory_path;
+      directory_path = tmp;
+    }
   }
-  if (directory_path)
-    directory_path = simplify_directory_path(directory_path);
-  else {
-    directory_path = simplify_directory_path(benchmarks_path);
-    if (!directory_exists(directory_path))
-    DIRECTORY_DOES_NOT_EXISTS:
-      die("directory '%s' does not exist", directory_path);
-    size_t directory_path_len = strlen(directory_path);
-    size_t missing_benchmarks_path_len = directory_path_len + 16;
-    missing_benchmarks_path = malloc(missing_benchmarks_path_len);
-    if (!missing_benchmarks_path)
-      out_of_memory("allocating missing benchmarks paths");
-    strcpy(missing_benchmarks_path, directory_path);
-    missing_benchmarks_path[directory_path_len] = '/';
-    strcpy(missing_benchmarks_path + directory_path_len + 1, "benchmarks");
-    benchmarks_path = missing_benchmarks_path;
-  }
-  if (benchmarks_path && directory_path && directory_exists(benchmarks_path) &&
-      file_exists(directory_path)) {
-    const char *tmp = benchmarks_path;
-    benchmarks_path = directory_path;
-    directory_path = tmp;
-  }
-  if (!file_exists(benchmarks_path))
+  if (benchmarks_path == stdin_path && zummary_path == stdin_path)
+    die("can not read both benchmarks and zummary from '%s'", stdin_path);
+  if (benchmarks_path != stdin_path && !file_exists(benchmarks_path))
     die("benchmarks file '%s' does not exist", benchmarks_path);
   if (benchmarks_path && output_path && !strcmp(benchmarks_path, output_path))
     die("identicial benchmarks and output path '%s'", benchmarks_path);
-  FILE *benchmarks_file = fopen(benchmarks_path, "r");
-  if (!benchmarks_file)
-    die("could not open and read '%s'", benchmarks_path);
-  if (!missing_benchmarks_path && !directory_exists(directory_path))
-    goto DIRECTORY_DOES_NOT_EXISTS;
-  size_t zummary_path_len = strlen(directory_path) + strlen("zummary") + 2;
-  zummary_path = malloc(zummary_path_len);
-  if (!zummary_path_len)
-    out_of_memory("allocating zummary path");
-  snprintf(zummary_path, zummary_path_len, "%s/%s", directory_path, "zummary");
-  if (!file_exists(zummary_path))
-    die("zummary file '%s' does not exist", zummary_path);
-  FILE *zummary_file = fopen(zummary_path, "r");
-  if (!zummary_file)
-    die("could not open and read '%s'", zummary_path);
+  if (runlim_logs) {
+    if (zummary_path)
+      die("can not combine '--runlim' and '--zummary %s'", zummary_path);
+    if (!missing_benchmarks_path && !directory_exists(directory_path))
+      goto DIRECTORY_DOES_NOT_EXISTS;
+  } else {
+    if (!zummary_path) {
+      if (!missing_benchmarks_path && !directory_exists(directory_path))
+        goto DIRECTORY_DOES_NOT_EXISTS;
+      zummary_path = find_file(directory_path, "zummary");
+    }
+    if (zummary_path != stdin_path && !file_exists(zummary_path))
+      die("zummary file '%s' does not exist", zummary_path);
+  }
+  for (size_t i = 0; i != size_merge_paths; i++) {
+    const char *path = merge_paths[i];
+    if (directory_exists(path))
+      merge_paths[i] = path = find_file(path, "zummary");
+    if (!file_exists(path))
+      die("merged zummary file '%s' does not exist", path);
+    if (zummary_path && zummary_path != stdin_path &&
+        same_file(zummary_path, path))
+      die("zummary '%s' can not be merged with itself", path);
+    for (size_t j = 0; j != i; j++)
+      if (same_file(merge_paths[j], path))
+        die("two merge paths '--merge %s' and '--merge %s' of the same file",
+            merge_paths[j], path);
+  }
+  if (speed_path) {
+    if (directory_exists(speed_path))
+      speed_path = find_file(speed_path, "zummary");
+    if (!file_exists(speed_path))
+      die("speed zummary file '%s' does not exist", speed_path);
+  }
+  if (history_path && size_merge_paths)
+    die("can not combine '--history' and '--merge'");
+  if (pack && keep)
+    die("can not combine '--pack' and '--keep'");
+  if (improve_budget && keep)
+    die("can not combine '--improve' and '--keep'");
+  if (size_node_types && size_nodes)
+    die("can not combine '-n %zu' and '--node-type'", size_nodes);
+  if (calibration_path) {
+    if (directory_exists(calibration_path))
+      calibration_path = find_file(calibration_path, "zummary");
+    if (!file_exists(calibration_path))
+      die("calibration zummary file '%s' does not exist", calibration_path);
+  }
   if (verbosity >= 0) {
     FILE *message_file = generate ? stderr : stdout;
     fprintf(message_file, "Zort Benchmarks Sorting\n");
@@ -676,47 +4126,38 @@ int main(int argc, char **argv) {
     fprintf(message_file, "Compiled %s\n", COMPILE);
     fflush(message_file);
   }
-  init_line_reading(benchmarks_file, benchmarks_path);
-  while (read_line()) {
-    struct benchmark benchmark;
-    parse_benchmark(&benchmark);
-    push_benchmark(&benchmark);
-  }
-  fclose(benchmarks_file);
-  if (!size_benchmarks)
-    die("could not find any benchmark in '%s'", benchmarks_path);
-  vrb(1, "parsed %zu benchmarks in '%s'", size_benchmarks, benchmarks_path);
-  init_line_reading(zummary_file, zummary_path);
-  if (!read_line())
-    die("failed to read header line in '%s'", zummary_path);
-  while (read_line()) {
-    struct zummary zummary;
-    parse_zummary(&zummary);
-    push_zummary(&zummary);
+  map_file(&benchmarks_mapping, benchmarks_path);
+  if (!runlim_logs)
+    map_file(&zummary_mapping, zummary_path);
+  if (use_cache && !runlim_logs &&
+      (benchmarks_path == stdin_path || zummary_path == stdin_path)) {
+    use_cache = false;
+    msg("not using cache while reading from '%s'", stdin_path);
   }
-  fclose(zummary_file);
-  vrb(1, "parsed %zu zummaries in '%s'", size_zummaries, zummary_path);
-  for (size_t i = 0; i != size_zummaries; i++) {
-    struct zummary *zummary = zummaries + i;
-    struct benchmark *benchmark = find_benchmark(zummary->name);
-    if (!benchmark)
-      die("could not find zummary entry '%s' in benchmarks", zummary->name);
-    zummary->benchmark = benchmark;
-    zummary->scheduled = false;
+  if (history_path && !runlim_logs) {
+    zummary_hash = hash_mapping(&zummary_mapping);
+    read_history();
   }
-  for (size_t i = 0; i != size_benchmarks; i++) {
-    struct benchmark *benchmark = benchmarks + i;
-    struct zummary *zummary = find_zummary(benchmark->name);
-    if (!zummary)
-      die("could not find benchmark entry '%s' in zummary", benchmark->name);
-    benchmark->zummary = zummary;
+  if (runlim_logs) {
+    parse_benchmarks();
+    parse_runlim_logs();
+    read_history();
+    append_history();
+    match_zummaries();
+  } else if (!use_cache || !load_cache()) {
+    parse_benchmarks();
+    parse_zummaries();
+    append_history();
+    match_zummaries();
+    if (use_cache)
+      write_cache();
   }
-  if (size_benchmarks == size_zummaries)
-    vrb(1, "zummaries and benchmarks match (found %zu of both)",
-        size_zummaries);
-  else
-    die("%zu benchmarks different from %zu zummaries", size_benchmarks,
-        size_zummaries);
+  update_history();
+  merge_zummaries();
+  calibrate_zummaries();
+  normalize_machine_speed();
+  select_subset();
+  init_hot();
   if (bucket_size)
     vrb(1, "using specified bucket size %zu", bucket_size);
   else {
@@ -737,7 +4178,12 @@ int main(int argc, char **argv) {
     vrb(1, "using default fast bucket memory limit of %u MB",
         fast_bucket_memory);
   }
-  if (size_nodes)
+  if (size_node_types) {
+    for (size_t i = 0; i != size_node_types; i++)
+      size_nodes += node_types[i].nodes;
+    vrb(1, "assuming %zu nodes of %zu types", size_nodes, size_node_types);
+    init_node_speeds();
+  } else if (size_nodes)
     vrb(1, "assuming specified number of nodes %zu", size_nodes);
   else {
     size_nodes = AVAILABLE_NODES;
@@ -787,57 +4233,57 @@ int main(int argc, char **argv) {
           "(with only %zu benchmarks less than bucket size)",
           last_bucket_size);
   }
-  buckets = calloc(tasks, sizeof *buckets);
-  if (!buckets)
-    out_of_memory("allocating buckets");
-  for (size_t i = 0; i != tasks; i++)
-    if (!(buckets[i].zummaries =
-              malloc(bucket_size * sizeof *buckets[i].zummaries)))
-      out_of_memory("allocating bucket");
+  if (!pack) {
+    buckets = allocate_zeroed(tasks * sizeof *buckets);
+    unsigned *slots = allocate(tasks * bucket_size * sizeof *slots);
+    for (size_t i = 0; i != tasks; i++)
+      buckets[i].zummaries = slots + i * bucket_size;
+  }
   if (keep) {
     for (size_t i = 0, j = 0; i != size_benchmarks; i++) {
       struct benchmark *benchmark = benchmarks + i;
       struct zummary *zummary = benchmark->zummary;
       assert(zummary);
-      assert(!zummary->scheduled);
       assert(zummary->benchmark == benchmark);
       struct bucket *bucket = buckets + j;
-      schedule_zummary(bucket, zummary);
+      schedule_zummary(bucket, zummary - zummaries);
       if (buckets[j].size >= bucket_size)
         j++;
     }
+  } else if (pack) {
+    time_order = sort_zummaries_by_time();
+    pack_buckets();
   } else {
-    sort_zummaries_by_time();
+    time_order = sort_zummaries_by_time();
+    memory_order = sort_zummaries_by_memory();
     size_t j = 0, limit = (fast_bucket_fraction * tasks) / 100u;
     for (size_t i = 0; i != size_zummaries; i++) {
-      struct zummary *zummary = zummaries + i;
-      if (zummary->status != 10 && zummary->status != 20)
+      unsigned idx = time_order[i];
+      if (!get_bit(hot.solved, idx))
         continue;
-      if (zummary->memory > fast_bucket_memory)
+      if (hot.memory[idx] > fast_bucket_memory)
         continue;
-      assert(!zummary->scheduled);
       struct bucket *bucket = buckets + j;
-      schedule_zummary(bucket, zummary);
-      zummary->scheduled = true;
+      schedule_zummary(bucket, idx);
       if (buckets[j].size >= bucket_size && ++j == limit)
         break;
     }
-    sort_zummaries_by_memory();
     size_t last = size_zummaries;
     j = tasks - 1;
     while (last) {
-      struct zummary *zummary = zummaries + --last;
-      if (zummary->scheduled)
+      unsigned idx = memory_order[--last];
+      if (get_bit(hot.scheduled, idx))
         continue;
       struct bucket *bucket = buckets + j;
-      schedule_zummary(bucket, zummary);
-      zummary->scheduled = true;
+      schedule_zummary(bucket, idx);
       if (scheduled != size_zummaries)
         j = next_bucket(j);
       else
         break;
     }
   }
+  if (!keep)
+    improve_buckets();
   size_t printed = 0;
   double sum_real = 0;
   double max_total_memory = 0;
@@ -855,6 +4301,8 @@ int main(int argc, char **argv) {
     }
   } else
     assert(!output_file);
+  if (!keep)
+    sort_buckets_by_decreasing_real();
   for (size_t i = 0; i != tasks; i++) {
     struct bucket *bucket = buckets + i;
     vrb(1, "bucket[%zu] maximum-time %.2f s, total-memory %.0f MB", i + 1,
@@ -863,12 +4311,13 @@ int main(int argc, char **argv) {
       max_total_memory = bucket->memory;
     sum_real += bucket->real;
     for (size_t j = 0; j != bucket->size; j++) {
-      struct zummary *zummary = bucket->zummaries[j];
+      unsigned idx = bucket->zummaries[j];
+      struct zummary *zummary = zummaries + idx;
       struct benchmark *benchmark = zummary->benchmark;
-      assert(zummary->scheduled);
+      assert(get_bit(hot.scheduled, idx));
       assert(benchmark);
-      vrb(2, "%9.0f s %6.0f MB  %s%s", zummary->real, zummary->memory,
-          zummary->name, zummary->memory_limit_hit ? " *" : "");
+      vrb(2, "%9.0f s %6.0f MB  %s%s", hot.real[idx], hot.memory[idx],
+          zummary->name, get_bit(hot.limit_hit, idx) ? " *" : "");
       if (!generate)
         continue;
       fprintf(output_file, "%zu", ++printed);
@@ -901,58 +4350,20 @@ int main(int argc, char **argv) {
   double costs = cents_per_kwh * power_usage / 100.0;
   msg("estimated-cost of %s %.2f (¢ %d * %.3f kWh / 100)",
       use_euro_sign ? "€" : "$", costs, cents_per_kwh, power_usage);
-  sort_buckets_by_real();
-  nodes = calloc(size_nodes, sizeof *nodes);
-  if (!nodes)
-    out_of_memory("allocating nodes");
-  double latency = 0;
-  for (size_t i = 0; i != tasks; i++) {
-    struct bucket *next = buckets + i;
-    struct bucket *replace = 0;
-    const size_t invalid_position = ~(size_t)0;
-    size_t pos = invalid_position;
-    for (size_t j = 0; j != size_nodes; j++) {
-      struct bucket *prev = nodes[j];
-      if (!prev) {
-        replace = 0;
-        pos = j;
-        break;
-      }
-      if (!replace || prev->end < replace->end) {
-        replace = prev;
-        pos = j;
-      }
-    }
-    double start = replace ? replace->end : 0;
-    double end = start + next->real;
-    next->start = start;
-    next->end = end;
-    assert(pos != invalid_position);
-    vrb(1, "running bucket[%zu] at node %zu after %.0f s (%.0f-%.0f)", i + 1,
-        pos, next->start, next->start, next->end);
-    nodes[pos] = next;
-    if (end > latency)
-      latency = end;
-  }
+  double latency = simulate_nodes();
   msg("execution-time span of %.0f s (%.2f h running %zu nodes in parallel)",
       latency, latency / 3600, size_nodes);
+  release_arena();
+  free(node_types);
+  free(merge_paths);
+  unmap_file(&history_mapping);
+  unmap_file(&manifest_mapping);
+  unmap_file(&cache_mapping);
+  unmap_file(&zummary_mapping);
+  unmap_file(&benchmarks_mapping);
   if (verbosity == 1)
     msg("run with two '-v' for bucket allocation details too");
   if (verbosity == 0)
     msg("run with '-v' for scheduling details");
-  free(nodes);
-  for (size_t i = 0; i != tasks; i++)
-    free(buckets[i].zummaries);
-  free(buckets);
-  for (size_t i = 0; i != size_zummaries; i++)
-    free(zummaries[i].name);
-  for (size_t i = 0; i != size_benchmarks; i++)
-    free(benchmarks[i].path), free(benchmarks[i].name);
-  free(zummaries);
-  free(benchmarks);
-  free(missing_benchmarks_path);
-  free(simplified_directory_path);
-  free(zummary_path);
-  free(line);
   return 0;
 }